@@ -0,0 +1,52 @@
+#pragma once
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/// @brief seed for configs that have none, so two runs of the same sweep time the same bodies
+static constexpr size_t default_seed = 1234567890;
+
+/// @brief Splits a comma separated option value, empty items are dropped
+static inline std::vector<std::string> split(const std::string& s) {
+    std::vector<std::string> out;
+    size_t start = 0;
+    while (start <= s.size()) {
+        size_t end = s.find(',', start);
+        if (end == std::string::npos) { end = s.size(); }
+        if (end > start) { out.push_back(s.substr(start, end - start)); }
+        start = end + 1;
+    }
+    return out;
+}
+
+/// @brief Nearest rank percentile of t, p in [0, 1]
+static inline double percentile(std::vector<double> t, double p) {
+    std::sort(t.begin(), t.end());
+    const size_t k = std::min(t.size() - 1, (size_t)(p * (t.size() - 1) + 0.5));
+    return t[k];
+}
+
+/// @brief Escapes s for use inside a json string, quotes, backslashes and control characters
+static inline std::string json_escape(const std::string& s) {
+    std::string out;
+    out.reserve(s.size());
+    for (const char c : s) {
+        switch (c) {
+            case '"': out += "\\\""; break;
+            case '\\': out += "\\\\"; break;
+            case '\n': out += "\\n"; break;
+            case '\r': out += "\\r"; break;
+            case '\t': out += "\\t"; break;
+            default:
+                if ((unsigned char)c < 0x20) {
+                    char buf[8];
+                    snprintf(buf, sizeof(buf), "\\u%04x", (unsigned char)c);
+                    out += buf;
+                } else {
+                    out += c;
+                }
+        }
+    }
+    return out;
+}
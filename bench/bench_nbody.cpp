@@ -0,0 +1,220 @@
+/*
+Purpose: Sweeps body counts, thread counts, solvers and simd kernels over the simulation configs and writes the timings as json
+Comments: Every case is initialized from its config with the config's seed, or a fixed one when the config has
+none, so two runs of the same sweep time the same bodies. Flops count 20 per pair interaction, the usual
+convention for the softened kernel, which makes GFLOP/s comparable between solvers but only nominal for fmm and pm
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <exception>
+#include <omp.h>
+#include <string>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "../src/simulation/simulation.hpp"
+#include "../src/simd/simd.hpp"
+
+static constexpr double flops_per_interaction = 20.0;
+
+/// @brief one solver as the cli would select it
+struct solver_case {
+    std::string name;
+    std::string solver;
+    std::string kernel;
+};
+
+struct result {
+    std::string config;
+    std::string type;
+    std::string solver;
+    std::string isa;
+    size_t width;
+    size_t bodies;
+    size_t threads;
+    size_t steps;
+    double median_ms;
+    double p95_ms;
+    double interactions;    // per step
+    std::string error;
+};
+
+static solver_case parse_solver(const std::string& s) {
+    // direct takes its kernel after a colon, every other solver ignores the kernel
+    const size_t colon = s.find(':');
+    if (colon != std::string::npos) { return { s, s.substr(0, colon), s.substr(colon + 1) }; }
+    if (s == "direct") { return { "direct:tiled", "direct", "tiled" }; }
+    return { s, s, "tiled" };
+}
+
+static void usage() {
+    fprintf(stderr,
+        "usage: nbody_bench [options]\n"
+        "  -f, --file PATH          config to sweep, may be repeated (default simulations/sample.yml)\n"
+        "  -b, --bodies N,...       body counts (default the config's points)\n"
+        "  -t, --threads N,...      thread counts (default all threads)\n"
+        "  -i, --isa I,...          simd kernels, avx512, avx2, sse, scalar or all (default the widest supported)\n"
+        "  -s, --solvers S,...      direct:rows, direct:tiled, direct:fused, bh, fmm, pm, p3m\n"
+        "                           (default direct:tiled,bh,fmm,pm,p3m)\n"
+        "  -n, --steps N            timed steps per case (default 10)\n"
+        "  -w, --warmup N           untimed steps per case (default 2)\n"
+        "  -o, --out PATH           json output (default stdout)\n");
+}
+
+/// @brief Times one case, a case that fails to construct is recorded with its error rather than ending the sweep
+static result run_case(const std::string& path, const solver_case& sc, simd::isa isa, size_t bodies, size_t threads, size_t steps, size_t warmup) {
+    const simd::table& k = simd::get(isa);
+    result r{ path, "", sc.name, k.name, k.width, bodies, threads, steps, 0.0, 0.0, 0.0, "" };
+
+    try {
+        simd::select(isa);
+
+        cliargs f;
+        f.path = path;
+        f.config.Load(path);
+        f.cpu = true;
+        f.headless = true;
+        f.solver = sc.solver;
+        f.kernel = sc.kernel;
+        if (!f.config.Has("seed")) { f.config.Set("seed", default_seed); }
+        if (bodies) { f.config.Set("points", bodies); }
+
+        r.type = f.config.Type();
+        r.bodies = f.config.Points();
+
+        // the thread count has to be set before construction, the rows kernel sizes its buffers by it
+        omp_set_num_threads(threads);
+        simulation sim(f);
+        const float ft = f.config.Fixedtime();
+
+        for (size_t i = 0; i < warmup; i++) { (sim.*sim.update)(ft); }
+
+        std::vector<double> t(steps);
+        double interactions = 0.0;
+        for (auto& v : t) {
+            v = std::chrono::duration<double, std::milli>((sim.*sim.update)(ft)).count();
+            interactions += sim.perf().interactions;
+        }
+
+        r.median_ms = percentile(t, 0.5);
+        r.p95_ms = percentile(t, 0.95);
+        r.interactions = interactions / steps;
+    } catch (const std::exception& e) {
+        r.error = e.what();
+    }
+
+    return r;
+}
+
+static void write_json(FILE* out, const std::vector<result>& results) {
+    fprintf(out, "{\n");
+    fprintf(out, "  \"detected_isa\": \"%s\",\n", json_escape(simd::get(simd::detect()).name).c_str());
+    fprintf(out, "  \"procs\": %d,\n", omp_get_num_procs());
+    fprintf(out, "  \"results\": [\n");
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const result& r = results[i];
+        const double ips = r.median_ms > 0.0 ? r.interactions / (r.median_ms * 1e-3) : 0.0;
+
+        fprintf(out, "    {\"config\": \"%s\", \"type\": \"%s\", \"solver\": \"%s\", \"isa\": \"%s\", \"simd_width\": %zu, \"bodies\": %zu, \"threads\": %zu, \"steps\": %zu",
+            json_escape(r.config).c_str(), json_escape(r.type).c_str(), json_escape(r.solver).c_str(), json_escape(r.isa).c_str(), r.width, r.bodies, r.threads, r.steps);
+        if (r.error.empty()) {
+            fprintf(out, ", \"median_ms\": %.4f, \"p95_ms\": %.4f, \"interactions_per_sec\": %.6e, \"gflops\": %.3f}",
+                r.median_ms, r.p95_ms, ips, ips * flops_per_interaction * 1e-9);
+        } else {
+            fprintf(out, ", \"error\": \"%s\"}", json_escape(r.error).c_str());
+        }
+        fprintf(out, "%s\n", i + 1 < results.size() ? "," : "");
+    }
+
+    fprintf(out, "  ]\n}\n");
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> configs;
+    std::vector<size_t> bodies;
+    std::vector<size_t> threads;
+    std::vector<solver_case> solvers;
+    std::vector<simd::isa> isas;
+    size_t steps = 10;
+    size_t warmup = 2;
+    std::string out;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") { usage(); return 0; }
+        if (i + 1 >= argc) { usage(); return 1; }
+
+        const std::string val = argv[++i];
+        if (arg == "-f" || arg == "--file") {
+            configs.push_back(val);
+        } else if (arg == "-b" || arg == "--bodies") {
+            for (const auto& s : split(val)) { bodies.push_back(std::stoull(s)); }
+        } else if (arg == "-t" || arg == "--threads") {
+            for (const auto& s : split(val)) { threads.push_back(std::stoull(s)); }
+        } else if (arg == "-s" || arg == "--solvers") {
+            for (const auto& s : split(val)) { solvers.push_back(parse_solver(s)); }
+        } else if (arg == "-i" || arg == "--isa") {
+            for (const auto& s : split(val)) {
+                if (s != "all") { isas.push_back(simd::parse(s)); continue; }
+                for (const auto i : { simd::AVX512, simd::AVX2, simd::SSE, simd::SCALAR }) {
+                    if (simd::supported(i)) { isas.push_back(i); }
+                }
+            }
+        } else if (arg == "-n" || arg == "--steps") {
+            steps = std::max<size_t>(std::stoull(val), 1);
+        } else if (arg == "-w" || arg == "--warmup") {
+            warmup = std::stoull(val);
+        } else if (arg == "-o" || arg == "--out") {
+            out = val;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (configs.empty()) { configs.push_back("simulations/sample.yml"); }
+    if (bodies.empty()) { bodies.push_back(0); }
+    if (isas.empty()) { isas.push_back(simd::detect()); }
+    if (threads.empty()) { threads.push_back(omp_get_max_threads()); }
+    if (solvers.empty()) {
+        for (const char* s : { "direct:tiled", "bh", "fmm", "pm", "p3m" }) { solvers.push_back(parse_solver(s)); }
+    }
+
+    // progress goes to stderr so stdout stays valid json
+    fprintf(stderr, "%-28s %-14s %-8s %10s %8s %12s %12s %12s\n", "config", "solver", "isa", "bodies", "threads", "median (ms)", "p95 (ms)", "GFLOP/s");
+
+    std::vector<result> results;
+    for (const auto& path : configs) {
+        for (const size_t n : bodies) {
+            for (const size_t t : threads) {
+                for (const auto& sc : solvers) {
+                    for (const auto isa : isas) {
+                        const result r = run_case(path, sc, isa, n, t, steps, warmup);
+                        results.push_back(r);
+
+                        if (!r.error.empty()) {
+                            fprintf(stderr, "%-28s %-14s %-8s %10zu %8zu   %s\n", path.c_str(), sc.name.c_str(), r.isa.c_str(), r.bodies, t, r.error.c_str());
+                            continue;
+                        }
+                        const double gflops = r.interactions * flops_per_interaction / (r.median_ms * 1e-3) * 1e-9;
+                        fprintf(stderr, "%-28s %-14s %-8s %10zu %8zu %12.2f %12.2f %12.2f\n",
+                            path.c_str(), sc.name.c_str(), r.isa.c_str(), r.bodies, t, r.median_ms, r.p95_ms, gflops);
+                    }
+                }
+            }
+        }
+    }
+
+    FILE* f = out.empty() ? stdout : fopen(out.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "could not open %s\n", out.c_str());
+        return 1;
+    }
+    write_json(f, results);
+    if (f != stdout) { fclose(f); }
+
+    return 0;
+}
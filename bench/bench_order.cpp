@@ -0,0 +1,285 @@
+/*
+Purpose: Compares body orderings for the tree solvers and the direct kernel, timing each step and counting cache
+misses with perf_event
+Comments: Counters are opened before the first parallel region with inherit set, so every openmp worker is counted
+with the main thread. The generic perf events have no L2 counter, last level read misses are reported instead.
+Counters the kernel or cpu does not provide, common under virtual machines and with perf_event_paranoid above 2,
+are written as null and the timings are still recorded. The tree solvers reorder by the configured ordering and
+reject radial keys, so the radial baseline is measured on the direct tiled kernel, whose bodies are sorted once by
+the ordering before the warmup and never reordered. The sort time of a direct case is that single sort
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <linux/perf_event.h>
+#include <omp.h>
+#include <string>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <vector>
+
+#include "bench_common.hpp"
+#include "../src/simulation/simulation.hpp"
+
+
+/// @brief one hardware cache event counted across the process and every thread it starts after opening
+struct counter {
+    int fd;
+
+    counter(uint64_t cache, uint64_t result) : fd(-1) {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = PERF_TYPE_HW_CACHE;
+        attr.config = cache | (PERF_COUNT_HW_CACHE_OP_READ << 8) | (result << 16);
+        attr.inherit = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    ~counter() { if (fd >= 0) { close(fd); } }
+
+    bool valid() const noexcept { return fd >= 0; }
+
+    /// @brief events so far, inherited counts of running threads are included in the read
+    uint64_t read() const noexcept {
+        uint64_t v = 0;
+        if (fd < 0 || ::read(fd, &v, sizeof(v)) != sizeof(v)) { return 0; }
+        return v;
+    }
+};
+
+/// @brief read accesses and misses of one cache level, per step
+struct level {
+    double loads = 0.0;
+    double misses = 0.0;
+    bool valid = false;
+};
+
+struct result {
+    std::string config;
+    std::string type;
+    std::string solver;
+    std::string ordering;
+    size_t bodies;
+    size_t threads;
+    size_t steps;
+    double median_ms;
+    double p95_ms;
+    double sort_ms;     // median reorder time, or the single sort of a direct case
+    level l1d;
+    level llc;
+    std::string error;
+};
+
+static void usage() {
+    fprintf(stderr,
+        "usage: nbody_bench_order [options]\n"
+        "  -f, --file PATH          config to run, may be repeated (default simulations/spiral.yml and simulations/tester.yml)\n"
+        "  -b, --bodies N,...       body counts (default the config's points)\n"
+        "  -t, --threads N          threads (default all threads)\n"
+        "  -s, --solvers S,...      bh, fmm or direct, direct runs the tiled kernel (default bh,fmm,direct)\n"
+        "  -r, --orderings O,...    morton, hilbert, radius (default all three, radius only for direct)\n"
+        "  -n, --steps N            timed steps per case (default 10)\n"
+        "  -w, --warmup N           untimed steps per case (default 2)\n"
+        "  -o, --out PATH           json output (default stdout)\n");
+}
+
+/// @brief counters for the l1 data cache and the last level cache, loads and misses of each
+struct counters {
+    counter l1d_loads{ PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_ACCESS };
+    counter l1d_misses{ PERF_COUNT_HW_CACHE_L1D, PERF_COUNT_HW_CACHE_RESULT_MISS };
+    counter llc_loads{ PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_RESULT_ACCESS };
+    counter llc_misses{ PERF_COUNT_HW_CACHE_LL, PERF_COUNT_HW_CACHE_RESULT_MISS };
+};
+
+/// @brief Times one case, a case that fails to construct is recorded with its error rather than ending the run
+static result run_case(counters& c, const std::string& path, const std::string& solver, const std::string& ordering,
+                       size_t bodies, size_t threads, size_t steps, size_t warmup) {
+    result r{ path, "", solver, ordering, bodies, threads, steps, 0.0, 0.0, 0.0, {}, {}, "" };
+
+    try {
+        cliargs f;
+        f.path = path;
+        f.config.Load(path);
+        f.cpu = true;
+        f.headless = true;
+        f.solver = solver;
+        f.kernel = "tiled";
+        if (solver != "direct") { f.config.Set("ordering", ordering); }
+        if (!f.config.Has("seed")) { f.config.Set("seed", default_seed); }
+        if (bodies) { f.config.Set("points", bodies); }
+
+        r.type = f.config.Type();
+        r.bodies = f.config.Points();
+
+        omp_set_num_threads(threads);
+        simulation sim(f);
+        const float ft = f.config.Fixedtime();
+
+        // the direct solver never reorders, its bodies keep whatever order they are given here
+        if (solver == "direct") {
+            reorder order(reorder::parse(ordering));
+            const auto s = std::chrono::high_resolution_clock::now();
+            order.sort(sim.get_data());
+            r.sort_ms = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - s).count();
+        }
+
+        for (size_t i = 0; i < warmup; i++) { (sim.*sim.update)(ft); }
+
+        const uint64_t l1l = c.l1d_loads.read(), l1m = c.l1d_misses.read();
+        const uint64_t lll = c.llc_loads.read(), llm = c.llc_misses.read();
+
+        std::vector<double> t(steps), s(steps);
+        for (size_t i = 0; i < steps; i++) {
+            t[i] = std::chrono::duration<double, std::milli>((sim.*sim.update)(ft)).count();
+            s[i] = std::chrono::duration<double, std::milli>(sim.perf().sort).count();
+        }
+
+        r.l1d = { (double)(c.l1d_loads.read() - l1l) / steps, (double)(c.l1d_misses.read() - l1m) / steps,
+                  c.l1d_loads.valid() && c.l1d_misses.valid() };
+        r.llc = { (double)(c.llc_loads.read() - lll) / steps, (double)(c.llc_misses.read() - llm) / steps,
+                  c.llc_loads.valid() && c.llc_misses.valid() };
+
+        r.median_ms = percentile(t, 0.5);
+        r.p95_ms = percentile(t, 0.95);
+        if (solver != "direct") { r.sort_ms = percentile(s, 0.5); }
+    } catch (const std::exception& e) {
+        r.error = e.what();
+    }
+
+    return r;
+}
+
+/// @brief miss rate as a percentage for the progress table, - when the counters are unavailable
+static std::string rate(const level& l) {
+    if (!l.valid || l.loads <= 0.0) { return "-"; }
+    char buf[32];
+    snprintf(buf, sizeof(buf), "%.2f", 100.0 * l.misses / l.loads);
+    return buf;
+}
+
+static void write_level(FILE* out, const char* name, const level& l) {
+    if (!l.valid) {
+        fprintf(out, ", \"%s_loads\": null, \"%s_misses\": null, \"%s_miss_rate\": null", name, name, name);
+        return;
+    }
+    fprintf(out, ", \"%s_loads\": %.6e, \"%s_misses\": %.6e, \"%s_miss_rate\": %.6f",
+        name, l.loads, name, l.misses, name, l.loads > 0.0 ? l.misses / l.loads : 0.0);
+}
+
+static void write_json(FILE* out, const std::vector<result>& results) {
+    fprintf(out, "{\n");
+    fprintf(out, "  \"isa\": \"%s\",\n", json_escape(simd::active().name).c_str());
+    fprintf(out, "  \"procs\": %d,\n", omp_get_num_procs());
+    fprintf(out, "  \"results\": [\n");
+
+    for (size_t i = 0; i < results.size(); i++) {
+        const result& r = results[i];
+
+        fprintf(out, "    {\"config\": \"%s\", \"type\": \"%s\", \"solver\": \"%s\", \"ordering\": \"%s\", \"bodies\": %zu, \"threads\": %zu, \"steps\": %zu",
+            json_escape(r.config).c_str(), json_escape(r.type).c_str(), json_escape(r.solver).c_str(), json_escape(r.ordering).c_str(), r.bodies, r.threads, r.steps);
+        if (r.error.empty()) {
+            fprintf(out, ", \"median_ms\": %.4f, \"p95_ms\": %.4f, \"sort_ms\": %.4f", r.median_ms, r.p95_ms, r.sort_ms);
+            write_level(out, "l1d", r.l1d);
+            write_level(out, "llc", r.llc);
+            fprintf(out, "}");
+        } else {
+            fprintf(out, ", \"error\": \"%s\"}", json_escape(r.error).c_str());
+        }
+        fprintf(out, "%s\n", i + 1 < results.size() ? "," : "");
+    }
+
+    fprintf(out, "  ]\n}\n");
+}
+
+int main(int argc, char* argv[]) {
+    // opened before anything starts the openmp team so the workers inherit them
+    counters c;
+
+    std::vector<std::string> configs;
+    std::vector<size_t> bodies;
+    std::vector<std::string> solvers;
+    std::vector<std::string> orderings;
+    size_t threads = omp_get_max_threads();
+    size_t steps = 10;
+    size_t warmup = 2;
+    std::string out;
+
+    for (int i = 1; i < argc; i++) {
+        const std::string arg = argv[i];
+        if (arg == "-h" || arg == "--help") { usage(); return 0; }
+        if (i + 1 >= argc) { usage(); return 1; }
+
+        const std::string val = argv[++i];
+        if (arg == "-f" || arg == "--file") {
+            configs.push_back(val);
+        } else if (arg == "-b" || arg == "--bodies") {
+            for (const auto& s : split(val)) { bodies.push_back(std::stoull(s)); }
+        } else if (arg == "-t" || arg == "--threads") {
+            threads = std::max<size_t>(std::stoull(val), 1);
+        } else if (arg == "-s" || arg == "--solvers") {
+            solvers = split(val);
+        } else if (arg == "-r" || arg == "--orderings") {
+            orderings = split(val);
+        } else if (arg == "-n" || arg == "--steps") {
+            steps = std::max<size_t>(std::stoull(val), 1);
+        } else if (arg == "-w" || arg == "--warmup") {
+            warmup = std::stoull(val);
+        } else if (arg == "-o" || arg == "--out") {
+            out = val;
+        } else {
+            usage();
+            return 1;
+        }
+    }
+
+    if (configs.empty()) { configs = { "simulations/spiral.yml", "simulations/tester.yml" }; }
+    if (bodies.empty()) { bodies.push_back(0); }
+    if (solvers.empty()) { solvers = { "bh", "fmm", "direct" }; }
+
+    // the tree solvers reject radial keys, the default sweep only pairs them with direct
+    const bool all = orderings.empty();
+    if (all) { orderings = { "morton", "hilbert", "radius" }; }
+
+    if (!c.l1d_misses.valid()) { fprintf(stderr, "l1d counters unavailable, only timings are recorded\n"); }
+    if (!c.llc_misses.valid()) { fprintf(stderr, "last level counters unavailable\n"); }
+
+    // progress goes to stderr so stdout stays valid json
+    fprintf(stderr, "%-28s %-6s %-8s %10s %12s %12s %12s %12s\n", "config", "solver", "ordering", "bodies", "median (ms)", "sort (ms)", "l1d miss %", "llc miss %");
+
+    std::vector<result> results;
+    for (const auto& path : configs) {
+        for (const size_t n : bodies) {
+            for (const auto& solver : solvers) {
+                for (const auto& ordering : orderings) {
+                    if (all && ordering == "radius" && solver != "direct") { continue; }
+
+                    const result r = run_case(c, path, solver, ordering, n, threads, steps, warmup);
+                    results.push_back(r);
+
+                    if (!r.error.empty()) {
+                        fprintf(stderr, "%-28s %-6s %-8s %10zu   %s\n", path.c_str(), solver.c_str(), ordering.c_str(), r.bodies, r.error.c_str());
+                        continue;
+                    }
+                    fprintf(stderr, "%-28s %-6s %-8s %10zu %12.2f %12.2f %12s %12s\n",
+                        path.c_str(), solver.c_str(), ordering.c_str(), r.bodies, r.median_ms, r.sort_ms, rate(r.l1d).c_str(), rate(r.llc).c_str());
+                }
+            }
+        }
+    }
+
+    FILE* f = out.empty() ? stdout : fopen(out.c_str(), "w");
+    if (!f) {
+        fprintf(stderr, "could not open %s\n", out.c_str());
+        return 1;
+    }
+    write_json(f, results);
+    if (f != stdout) { fclose(f); }
+
+    return 0;
+}
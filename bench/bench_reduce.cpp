@@ -0,0 +1,63 @@
+/*
+Purpose: Isolates the cost of reducing the per thread acceleration rows against thread count
+Comments: Compares the previous row serial reduction, one parallel region per row, against matrix::sum_rows
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <omp.h>
+#include <vector>
+
+#include "../src/matrix/matrix.hpp"
+
+static constexpr size_t runs = 9;
+static constexpr size_t bodies = 1000000;
+
+template<typename F>
+static double median_ms(F&& f) {
+    std::vector<double> t(runs);
+    for (auto& v : t) {
+        auto s = std::chrono::high_resolution_clock::now();
+        f();
+        v = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - s).count();
+    }
+
+    std::sort(t.begin(), t.end());
+    return t[runs / 2];
+}
+
+int main() {
+    const int max_threads = omp_get_max_threads();
+    printf("%zu bodies\n%-10s %12s %12s %10s\n", bodies, "threads", "serial (ms)", "block (ms)", "speedup");
+
+    for (int threads = 1; threads <= max_threads; threads *= 2) {
+        omp_set_num_threads(threads);
+        matrix m(threads, bodies);
+
+        auto fill = [&]() {
+            for (size_t r = 0; r < m.rows(); r++) {
+                std::fill(m.row(r), m.row(r) + m.cols(), 1.0f);
+            }
+        };
+
+        // previous path, a separate parallel region per row
+        fill();
+        double tserial = median_ms([&]() {
+            float* __restrict top = m.row(0);
+            for (size_t r = 1; r < m.rows(); r++) {
+                #pragma omp parallel for simd schedule(static)
+                for (size_t c = 0; c < m.cols(); c++) {
+                    top[c] += m(r, c);
+                }
+            }
+        });
+
+        fill();
+        double tblock = median_ms([&]() { m.sum_rows(); });
+
+        printf("%-10d %12.3f %12.3f %9.2fx\n", threads, tserial, tblock, tserial / tblock);
+    }
+
+    return 0;
+}
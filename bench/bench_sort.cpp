@@ -0,0 +1,81 @@
+/*
+Purpose: Compares the parallel radix sort against the previous std::sort over key/index pairs
+Comments: Keys are morton codes of uniformly distributed bodies, times are the median of several runs
+*/
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <random>
+#include <vector>
+
+#include "../src/sort/radix.hpp"
+
+static constexpr size_t runs = 5;
+
+/// @brief spreads the 32 bits of v into the even bits of a 64 bit word, as the morton kernels do
+static uint64_t spread(uint64_t v) {
+    v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+    v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+    v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+    v = (v | (v << 2)) & 0x3333333333333333ull;
+    v = (v | (v << 1)) & 0x5555555555555555ull;
+    return v;
+}
+
+template<typename F>
+static double median_ms(F&& f) {
+    std::vector<double> t(runs);
+    for (auto& v : t) {
+        auto s = std::chrono::high_resolution_clock::now();
+        f();
+        v = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - s).count();
+    }
+
+    std::sort(t.begin(), t.end());
+    return t[runs / 2];
+}
+
+int main() {
+    std::default_random_engine gen(1234567890);
+    std::uniform_int_distribution<uint32_t> coord;
+
+    printf("%-10s %12s %12s %10s\n", "bodies", "std (ms)", "radix (ms)", "speedup");
+
+    for (const size_t n : { 100000ul, 1000000ul, 10000000ul }) {
+        std::vector<uint64_t> codes(n);
+        for (auto& c : codes) {
+            c = spread(coord(gen)) | (spread(coord(gen)) << 1);
+        }
+
+        // previous path, pairs of key and index sorted with std::sort
+        std::vector<std::pair<uint64_t, size_t>> pairs(n);
+        double tstd = median_ms([&]() {
+            #pragma omp parallel for simd schedule(static)
+            for (size_t i = 0; i < n; i++) { pairs[i] = { codes[i], i }; }
+            std::sort(pairs.begin(), pairs.end());
+        });
+
+        // radix path, scratch is reused between runs as it is between frames
+        radix sorter;
+        std::vector<uint64_t> keys(n);
+        std::vector<uint32_t> idxs(n);
+        double trdx = median_ms([&]() {
+            #pragma omp parallel for simd schedule(static)
+            for (size_t i = 0; i < n; i++) { keys[i] = codes[i]; idxs[i] = i; }
+            sorter.sort(keys, idxs);
+        });
+
+        // sanity check both orders agree
+        for (size_t i = 0; i < n; i++) {
+            if (keys[i] != pairs[i].first) {
+                fprintf(stderr, "radix sort mismatch at %zu\n", i);
+                return 1;
+            }
+        }
+
+        printf("%-10zu %12.2f %12.2f %9.2fx\n", n, tstd, trdx, tstd / trdx);
+    }
+
+    return 0;
+}
@@ -1,53 +1,109 @@
 #include "app.hpp"
 
+#include <algorithm>
 #include <functional>
 #include <chrono>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
 
 
 /// @brief Handles application starting and managing the main loop
 /// @param f User defined cli arguments
 /// @return 0 if successful
 int app::run(const cliargs& f) {
-    if (!f.quiet) { printf("\033c"); }
+    // kernels have to be chosen before the simulation initializes, the zcurve sort already uses them
+    simd::select(simd::parse(f.isa));
+
+    // a quarter of the machine evaluates diagnostics, the rest stays with the simulation. The team size only
+    // applies to the thread that sets it, so the simulation thread sets it again
+    const int share = f.diagnostics_every ? std::max(omp_get_max_threads() / 4, 1) : 0;
+    threads = std::max(omp_get_max_threads() - share, 1);
+    omp_set_num_threads(threads);
+
     sim = simulation(f);
-    ren = renderer();
+
+    if (!f.trajectory.empty()) {
+        traj = std::make_unique<trajectory>(f.trajectory, sim.bodies(), f.trajectory_every, f.compress);
+    }
+
+    if (f.diagnostics_every) {
+        diag = std::make_unique<diagnostics>(sim.bodies(), f.diagnostics_every, share, sim.get_data().precise());
+        diag->record(sim.get_data(), sim.start());
+    }
+
+    if (f.headless) {
+        if (f.solver == "direct" && !f.cpu) {
+            throw std::runtime_error("headless mode requires a cpu solver");
+        }
+        return headless_loop(f);
+    }
+
+    // the gpu solver keeps bodies on the device, host data never advances past the initial state
+    const bool gpu = f.solver == "direct" && !f.cpu;
+    if (gpu && (f.checkpoint_every || traj || diag)) {
+        throw std::runtime_error("checkpoints, trajectories and diagnostics require a cpu solver");
+    }
+
+    if (!f.quiet) { printf("\033c"); }
+    ren = std::make_unique<renderer>();
     
-    ren.init(sim.get_data(), f.path);
+    ren->init(sim.get_data(), f.path, gpu);
+    sim.attach(ren->gpu());
     if (main_loop(f)) { return 1; }
     cleanup();
 
     return 0;
 }
 
+/// @brief Draws frames as fast as the swapchain allows while the simulation steps on its own thread,
+/// the simulation never waits on the renderer so a slow step never drops the frame rate and vsync never throttles physics
+/// @param f User defined cli arguments
+/// @return 0 if successful
 int app::main_loop(const cliargs& f) {
     using namespace std::chrono;
-    double sim_sum = 0.0;
     double ren_sum = 0.0;
-    double tot_sum = 0.0;
     size_t count = 0;
 
+    // seed every slot with the initial state so the first frames have something to draw
+    renderer::frame slots[renderer::FRAME_SLOTS];
+    for (uint32_t i = 0; i < renderer::FRAME_SLOTS; i++) {
+        slots[i] = ren->slot(i);
+        publish(slots[i], sim.get_data());
+    }
+    frames = std::make_unique<triple<renderer::frame>>(slots[0], slots[1], slots[2]);
+
+    stop = false;
+    std::thread worker(&app::sim_loop, this, std::cref(f));
+
+    auto start = high_resolution_clock::now();
     auto frame_start = high_resolution_clock::now();
     auto last_print = high_resolution_clock::now();
-    auto fixedtime = f.config.Fixedtime();
 
-    while (!ren.should_close()) {
+    while (!ren->should_close()) {
         count++;
         auto time = high_resolution_clock::now();
         float dt = duration<float>(high_resolution_clock::now() - frame_start).count();
         frame_start = time;
 
-        auto sim_time = std::invoke(sim.update, sim, fixedtime).count() * 0.000001;
-        sim_sum += sim_time;
-
-        auto ren_time = ren.render(sim.get_data(), dt).count() * 0.000001;
+        if (frames->pending()) {
+            // the gpu may still be reading the current slot, it must be idle before the simulation gets it back
+            ren->retire(frames->front());
+            frames->acquire();
+        }
+        auto ren_time = ren->render(frames->front(), dt).count() * 0.000001;
         ren_sum += ren_time;
-        tot_sum += sim_time + ren_time;
 
         // lock debugging output to 100ms refresh
         if (!f.quiet && high_resolution_clock::now() - last_print >= milliseconds(f.refresh)) {
+            const size_t done = steps.load(std::memory_order_relaxed);
+            const double sim_sum = sim_ns.load(std::memory_order_relaxed) * 0.000001;
+            const double sim_time = last_ns.load(std::memory_order_relaxed) * 0.000001;
+            const double elapsed = duration<double>(high_resolution_clock::now() - start).count();
+
             printf(
                 "\033[H"
-                "Frame %zu"
+                "Frame %zu, Step %zu, SIMD %s"
                 "\n\nSimulation (ms):"
                 "\n\tAverage: %.2f     "
                 "\n\tLast:    %.2f     "
@@ -56,20 +112,205 @@ int app::main_loop(const cliargs& f) {
                 "\n\tLast:    %.2f     "
                 "\n\nPerformance:"
                 "\n\tFPS:     %.2f     "
+                "\n\tSteps/s: %.2f     "
                 "\n",
-                count, 
-                sim_sum / count, sim_time,
+                count, sim.start() + done, simd::active().name,
+                sim_sum / std::max<size_t>(done, 1), sim_time,
                 ren_sum / count, ren_time,
-                1000.00 / (tot_sum / count)
+                count / elapsed,
+                done / elapsed
             );
+            if (traj) { print_trajectory(); }
+            if (diag) { print_diagnostics(); }
 
             last_print = high_resolution_clock::now();
         }
     }
 
+    stop = true;
+    if (worker.joinable()) { worker.join(); }
+    if (traj) { traj->flush(); }
     return 0;
 }
 
+/// @brief Writes the current state into a frame, masses are only copied when bodies were reordered since the
+/// frame was last written
+/// @param fr Frame owned by the caller
+/// @param d Simulation data
+void app::publish(renderer::frame& fr, const data& d) noexcept {
+    const size_t bytes = d.bodies() * sizeof(float);
+    memcpy(fr.posx, d.posx(), bytes);
+    memcpy(fr.posy, d.posy(), bytes);
+
+    if (fr.order != d.order()) {
+        memcpy(fr.mass, d.mass(), bytes);
+        fr.order = d.order();
+    }
+}
+
+/// @brief Steps the simulation until stop is set, publishing every finished step to the renderer
+/// @param f User defined cli arguments
+void app::sim_loop(const cliargs& f) {
+    omp_set_num_threads(threads);
+    auto fixedtime = f.config.Fixedtime();
+    Compute* gpu = ren->gpu();
+
+    while (!stop.load(std::memory_order_relaxed)) {
+        auto sim_time = std::invoke(sim.update, sim, fixedtime).count();
+
+        const size_t step = sim.start() + steps.load(std::memory_order_relaxed) + 1;
+        if (f.checkpoint_every && step % f.checkpoint_every == 0) { sim.checkpoint(f.checkpoint, step); }
+        if (traj && traj->due(step)) { traj->record(sim.get_data(), step); }
+        if (diag && diag->due(step)) { diag->record(sim.get_data(), step); }
+
+        // the gpu solver copies on the device, host data never advances
+        if (gpu) {
+            gpu->publish(frames->back().slot);
+        } else {
+            publish(frames->back(), sim.get_data());
+        }
+        frames->publish();
+
+        sim_ns.fetch_add(sim_time, std::memory_order_relaxed);
+        last_ns.store(sim_time, std::memory_order_relaxed);
+        steps.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+/// @brief Runs a fixed number of steps without a window and reports per phase timings
+/// @param f User defined cli arguments
+/// @return 0 if successful
+int app::headless_loop(const cliargs& f) {
+    using namespace std::chrono;
+    double sort_sum = 0.0;
+    double tree_sum = 0.0;
+    double force_sum = 0.0;
+    double tot_sum = 0.0;
+    double interactions = 0.0;
+    size_t reorders = 0;
+
+    auto fixedtime = f.config.Fixedtime();
+    auto last_print = high_resolution_clock::now();
+
+    // restored runs continue counting from the snapshot step
+    const size_t first = sim.start() + 1;
+    const size_t last = sim.start() + f.steps;
+
+    for (size_t step = first; step <= last; step++) {
+        std::invoke(sim.update, sim, fixedtime);
+
+        const auto& p = sim.perf();
+        sort_sum += p.sort.count() * 0.000001;
+        tree_sum += p.tree.count() * 0.000001;
+        force_sum += p.force.count() * 0.000001;
+        tot_sum += p.total.count() * 0.000001;
+        interactions += p.interactions;
+        reorders += p.reorders;
+
+        // checkpoint writes are not part of the step timings
+        if (f.checkpoint_every && step % f.checkpoint_every == 0) { sim.checkpoint(f.checkpoint, step); }
+        if (traj && traj->due(step)) { traj->record(sim.get_data(), step); }
+        if (diag && diag->due(step)) { diag->record(sim.get_data(), step); }
+
+        if (!f.quiet && high_resolution_clock::now() - last_print >= milliseconds(f.refresh)) {
+            printf("Step %zu / %zu\n", step, last);
+            last_print = high_resolution_clock::now();
+        }
+    }
+
+    const double steps = f.steps;
+    const double integrate_sum = tot_sum - sort_sum - tree_sum - force_sum;
+
+    printf(
+        "Bodies %zu, Steps %zu, SIMD %s (%zu lanes)"
+        "\n\nPhases (average ms):"
+        "\n\tSort:      %.3f"
+        "\n\tTree:      %.3f"
+        "\n\tForce:     %.3f"
+        "\n\tIntegrate: %.3f"
+        "\n\tTotal:     %.3f"
+        "\n\nPerformance:"
+        "\n\tSteps/s:        %.2f"
+        "\n\tInteractions/s: %.3e"
+        "\n",
+        sim.bodies(), f.steps, simd::active().name, simd::active().width,
+        sort_sum / steps,
+        tree_sum / steps,
+        force_sum / steps,
+        integrate_sum / steps,
+        tot_sum / steps,
+        1000.0 * steps / tot_sum,
+        interactions / (tot_sum * 0.001)
+    );
+
+    // only the tree solvers reorder, the sort phase is the whole cost of a reorder
+    if (reorders) {
+        printf(
+            "\nReorder (%s):"
+            "\n\tEvery:     %.2f steps"
+            "\n\tCost:      %.3f ms"
+            "\n",
+            sim.policy().name(),
+            steps / reorders,
+            sort_sum / reorders
+        );
+    }
+
+    if (!f.dump.empty()) { sim.dump(f.dump); }
+    if (f.accuracy) { print_accuracy(); }
+
+    if (traj) {
+        traj->flush();
+        print_trajectory();
+    }
+
+    if (diag) {
+        diag->flush();
+        print_diagnostics();
+    }
+    return 0;
+}
+
+/// @brief Prints writer backpressure, stalls are frames the simulation had to wait on a free buffer for
+void app::print_trajectory() {
+    auto t = traj->perf();
+    printf(
+        "\nTrajectory:"
+        "\n\tFrames:  %zu     "
+        "\n\tWritten: %.2f MB     "
+        "\n\tStalls:  %zu     "
+        "\n\tWaited:  %.2f ms     "
+        "\n",
+        t.frames, t.bytes * 0.000001, t.stalls, t.waited.count() * 0.000001
+    );
+}
+
+/// @brief Prints fmm error against the direct sum at every expansion order for the final state
+void app::print_accuracy() {
+    auto report = sim.fmm_accuracy(1000);
+    printf("\nFMM accuracy (relative to direct):\n\tOrder  RMS        Max        Force (ms)  Interactions\n");
+    for (const auto& r : report) {
+        printf("\t%-6zu %-10.3e %-10.3e %-11.3f %zu\n", r.order, r.rms, r.max, r.time.count() * 0.000001, r.interactions);
+    }
+}
+
+/// @brief Prints drift of the conserved quantities since the first sample, skipped samples arrived while one was still being evaluated
+void app::print_diagnostics() {
+    auto r = diag->latest();
+    printf(
+        "\nDiagnostics (step %zu):"
+        "\n\tEnergy drift:   %+.3e     "
+        "\n\tMomentum drift: %.3e     "
+        "\n\tAngular drift:  %+.3e     "
+        "\n\tVirial ratio:   %.4f     "
+        "\n\tSamples:        %zu (%zu skipped, %.2f ms)     "
+        "\n",
+        r.last.step,
+        r.energy_drift(), r.momentum_drift(), r.angular_drift(), r.last.virial(),
+        r.samples, r.skipped, r.time.count() * 0.000001
+    );
+}
+
 void app::cleanup() {
-    ren.cleanup();
+    ren->cleanup();
 }
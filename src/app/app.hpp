@@ -1,16 +1,49 @@
 #pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+
 #include "../simulation/simulation.hpp"
 #include "../renderer/renderer.hpp"
+#include "../trajectory/trajectory.hpp"
+#include "../diagnostics/diagnostics.hpp"
+#include "../triple/triple.hpp"
 #include "../cli/cli.hpp"
 
 struct app {
     private:
     simulation sim = simulation();
-    renderer   ren = renderer();
+
+    // only created when running with a window, constructing it loads vulkan
+    std::unique_ptr<renderer> ren;
+
+    // only created when a trajectory file is requested, owns the writer thread
+    std::unique_ptr<trajectory> traj;
+
+    // only created when diagnostics are requested, owns the evaluation thread
+    std::unique_ptr<diagnostics> diag;
+
+    // frames published by the simulation thread straight into renderer memory, the renderer draws the newest one
+    std::unique_ptr<triple<renderer::frame>> frames;
+
+    // team size of the simulation's parallel regions, what diagnostics leave of the machine
+    int threads = 1;
+
+    // shared with the simulation thread while the window is open
+    std::atomic<bool> stop{false};
+    std::atomic<size_t> steps{0};
+    std::atomic<int64_t> sim_ns{0};
+    std::atomic<int64_t> last_ns{0};
 
     int main_loop(const cliargs& f);
+    void sim_loop(const cliargs& f);
+    static void publish(renderer::frame& fr, const data& d) noexcept;
+    int headless_loop(const cliargs& f);
+    void print_trajectory();
+    void print_diagnostics();
+    void print_accuracy();
     void cleanup();
 
     public:
     int run(const cliargs& f);
-};
\ No newline at end of file
+};
@@ -15,6 +15,20 @@ void cliargs::parse(int argc, char* argv[]) {
                 "\nUsage: nbody [Options]"
                 "\n\nOPTIONS:"
                 "\n\t--cpu: use cpu computation"
+                "\n\t--solver: force solver to use (direct, bh, fmm, pm, p3m)"
+                "\n\t--kernel: all pairs kernel used by the direct cpu solver (rows, tiled, fused)"
+                "\n\t--isa: simd kernels to use (auto, avx512, avx2, sse, scalar), auto picks the widest the cpu supports"
+                "\n\t--headless: run without a window, requires --steps"
+                "\n\t--steps: number of steps to run in headless mode"
+                "\n\t--dump: write the final state as csv when running headless"
+                "\n\t--accuracy: report fmm error against the direct kernel for every order when running headless"
+                "\n\t--checkpoint-every: write a snapshot every n steps (0 disables)"
+                "\n\t--checkpoint: snapshot file written by --checkpoint-every (default nbody.snap)"
+                "\n\t--restore: resume from a snapshot instead of the configured initialization"
+                "\n\t--trajectory: stream positions to this file from a background thread"
+                "\n\t--trajectory-every: steps between trajectory frames (default 1)"
+                "\n\t--compress: zlib compress trajectory frames"
+                "\n\t--diagnostics: compute energy and momentum drift every n steps in the background (0 disables)"
                 "\n\t-q, --quiet: quiet perf output"
                 "\n\t--refresh: set refresh rate of perf output"
                 "\n\t-f, --file: config file for simulation"
@@ -23,6 +37,56 @@ void cliargs::parse(int argc, char* argv[]) {
             exit(0);
         } else if (v == "--cpu") {
             cpu = true;
+        } else if (v == "--solver") {
+            if (argc > i+1) {
+                solver = argv[++i];
+            }
+        } else if (v == "--kernel") {
+            if (argc > i+1) {
+                kernel = argv[++i];
+            }
+        } else if (v == "--isa") {
+            if (argc > i+1) {
+                isa = argv[++i];
+            }
+        } else if (v == "--headless") {
+            headless = true;
+        } else if (v == "--steps") {
+            if (argc > i+1) {
+                steps = util::parse_string(argv[++i]);
+            }
+        } else if (v == "--dump") {
+            if (argc > i+1) {
+                dump = argv[++i];
+            }
+        } else if (v == "--accuracy") {
+            accuracy = true;
+        } else if (v == "--checkpoint-every") {
+            if (argc > i+1) {
+                checkpoint_every = util::parse_string(argv[++i]);
+            }
+        } else if (v == "--checkpoint") {
+            if (argc > i+1) {
+                checkpoint = argv[++i];
+            }
+        } else if (v == "--restore") {
+            if (argc > i+1) {
+                restore = argv[++i];
+            }
+        } else if (v == "--trajectory") {
+            if (argc > i+1) {
+                trajectory = argv[++i];
+            }
+        } else if (v == "--trajectory-every") {
+            if (argc > i+1) {
+                trajectory_every = util::parse_string(argv[++i]);
+            }
+        } else if (v == "--diagnostics") {
+            if (argc > i+1) {
+                diagnostics_every = util::parse_string(argv[++i]);
+            }
+        } else if (v == "--compress") {
+            compress = true;
         } else if (v == "-q" || v == "--quiet") {
             quiet = true;
         } else if (v == "--refresh") {
@@ -37,4 +101,12 @@ void cliargs::parse(int argc, char* argv[]) {
             throw std::runtime_error(("unrecognized argument \"" + v + "\"").c_str());
         }
     }
-}
\ No newline at end of file
+
+    // cli flags take priority over the config file
+    if (solver.empty()) { solver = config.Solver(); }
+    if (kernel.empty()) { kernel = config.Kernel(); }
+
+    if (headless && steps == 0) {
+        throw std::runtime_error("--headless requires --steps greater than 0");
+    }
+}
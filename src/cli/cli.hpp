@@ -5,13 +5,27 @@
 
 struct cliargs {
     public:
-    cliargs() : refresh(100), cpu(false), quiet(false), path("") {}
+    cliargs() : path(""), checkpoint("nbody.snap"), isa("auto"), refresh(100), steps(0), checkpoint_every(0), trajectory_every(1), diagnostics_every(0), cpu(false), quiet(false), headless(false), compress(false), accuracy(false) {}
 
     void parse(int argc, char* argv[]);
 
     Config config;
     std::string path;
+    std::string solver;
+    std::string kernel;
+    std::string dump;
+    std::string checkpoint;
+    std::string restore;
+    std::string trajectory;
+    std::string isa;
     size_t refresh;
+    size_t steps;
+    size_t checkpoint_every;
+    size_t trajectory_every;
+    size_t diagnostics_every;
     bool cpu;
     bool quiet;
+    bool headless;
+    bool compress;
+    bool accuracy;
 };
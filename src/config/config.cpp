@@ -6,6 +6,21 @@
 #define TYPE "type"
 #define SEED "seed"
 
+// solver config data
+#define SOLVER "solver"
+#define THETA "theta"
+#define KERNEL "kernel"
+#define INTEGRATOR "integrator"
+#define LEVELS "levels"
+#define ETA "eta"
+#define ORDER "order"
+#define GRID "grid"
+#define PRECISE "precise"
+#define ORDERING "ordering"
+#define RESORT "resort"
+#define RESORTEVERY "resortevery"
+#define RESORTTHRESHOLD "resortthreshold"
+
 // spiral config data
 #define RX "rx"
 #define RXSCALE "rxscale"
@@ -42,6 +57,45 @@ float Config::Fixedtime() const noexcept {
 std::string Config::Type() const noexcept {
     return conf[TYPE].as<std::string>("cluster");
 }
+std::string Config::Solver() const noexcept {
+    return conf[SOLVER].as<std::string>("direct");
+}
+std::string Config::Kernel() const noexcept {
+    return conf[KERNEL].as<std::string>("rows");
+}
+std::string Config::Integrator() const noexcept {
+    return conf[INTEGRATOR].as<std::string>("euler");
+}
+size_t Config::Levels() const noexcept {
+    return conf[LEVELS].as<size_t>(8);
+}
+float Config::Eta() const noexcept {
+    return conf[ETA].as<float>(0.01f);
+}
+float Config::Theta() const noexcept {
+    return conf[THETA].as<float>(0.5f);
+}
+size_t Config::Order() const noexcept {
+    return conf[ORDER].as<size_t>(4);
+}
+size_t Config::Grid() const noexcept {
+    return conf[GRID].as<size_t>(256);
+}
+bool Config::Precise() const noexcept {
+    return conf[PRECISE].as<bool>(false);
+}
+std::string Config::Ordering() const noexcept {
+    return conf[ORDERING].as<std::string>("morton");
+}
+std::string Config::Resort() const noexcept {
+    return conf[RESORT].as<std::string>("always");
+}
+size_t Config::ResortEvery() const noexcept {
+    return conf[RESORTEVERY].as<size_t>(8);
+}
+float Config::ResortThreshold() const noexcept {
+    return conf[RESORTTHRESHOLD].as<float>(0.05f);
+}
 
 SpiralConfig Config::Spiral() const noexcept {
     return {
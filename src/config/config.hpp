@@ -39,10 +39,28 @@ struct Config {
     public:
     void Load(const std::string& path);
 
+    /// @brief overrides a key after loading, used by the benchmark suite to sweep configs
+    template<typename T>
+    void Set(const std::string& key, const T& value) { conf[key] = value; }
+    bool Has(const std::string& key) const noexcept { return (bool)conf[key]; }
+
     size_t Seed() const noexcept;
     size_t Points() const noexcept;
     float Fixedtime() const noexcept;
     std::string Type() const noexcept;
+    std::string Solver() const noexcept;
+    std::string Kernel() const noexcept;
+    std::string Integrator() const noexcept;
+    size_t Levels() const noexcept;
+    float Eta() const noexcept;
+    float Theta() const noexcept;
+    size_t Order() const noexcept;
+    size_t Grid() const noexcept;
+    bool Precise() const noexcept;
+    std::string Ordering() const noexcept;
+    std::string Resort() const noexcept;
+    size_t ResortEvery() const noexcept;
+    float ResortThreshold() const noexcept;
 
     SpiralConfig Spiral() const noexcept;
     ClusterConfig Cluster() const noexcept;
@@ -5,12 +5,17 @@
 #include <omp.h>
 #include <vector>
 #include <algorithm>
+#include <cstdint>
+#include <sys/mman.h>
 
 #include "../definitions/macros.hpp"
 #include "../matrix/matrix.hpp"
 #include "../util/util.hpp"
 
-/// @brief Hold the raw underlying simulation data and provides a simple interface to access it
+/// @brief Hold the raw underlying simulation data and provides a simple interface to access it,
+/// every array has a shadow so reorders can gather out of place and swap pointers, arrays may also
+/// point into a mapped snapshot in which case they are unmapped rather than freed. Precise data also
+/// keeps the rounding error of every position, so a position is posx + posxl
 struct data {
     private:
     size_t bodies_;
@@ -19,9 +24,104 @@ struct data {
     float* __restrict velx_;
     float* __restrict vely_;
     float* __restrict mass_;
+    uint32_t* __restrict id_;
+    float* __restrict sposx_;
+    float* __restrict sposy_;
+    float* __restrict svelx_;
+    float* __restrict svely_;
+    float* __restrict smass_;
+    uint32_t* __restrict sid_;
+    float* __restrict posxl_;
+    float* __restrict posyl_;
+    float* __restrict sposxl_;
+    float* __restrict sposyl_;
+    void* map_;
+    size_t map_size_;
+    uint64_t order_;
     matrix accx_;
     matrix accy_;
 
+    template<typename T>
+    static T* alloc(size_t n) { return (T*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(n*sizeof(T))); }
+
+    void allocate() noexcept {
+        posx_ = alloc<float>(bodies_); sposx_ = alloc<float>(bodies_);
+        posy_ = alloc<float>(bodies_); sposy_ = alloc<float>(bodies_);
+        velx_ = alloc<float>(bodies_); svelx_ = alloc<float>(bodies_);
+        vely_ = alloc<float>(bodies_); svely_ = alloc<float>(bodies_);
+        mass_ = alloc<float>(bodies_); smass_ = alloc<float>(bodies_);
+        id_ = alloc<uint32_t>(bodies_); sid_ = alloc<uint32_t>(bodies_);
+    }
+
+    // mapped arrays are released with the mapping itself
+    void drop(void* p) noexcept {
+        const bool mapped = (char*)p >= (char*)map_ && (char*)p < (char*)map_ + map_size_;
+        if (p && !mapped) { free(p); }
+    }
+
+    void release() noexcept {
+        drop(posx_); drop(sposx_);
+        drop(posy_); drop(sposy_);
+        drop(velx_); drop(svelx_);
+        drop(vely_); drop(svely_);
+        drop(mass_); drop(smass_);
+        drop(id_); drop(sid_);
+        drop(posxl_); drop(sposxl_);
+        drop(posyl_); drop(sposyl_);
+
+        posx_ = sposx_ = nullptr;
+        posy_ = sposy_ = nullptr;
+        velx_ = svelx_ = nullptr;
+        vely_ = svely_ = nullptr;
+        mass_ = smass_ = nullptr;
+        id_ = sid_ = nullptr;
+        posxl_ = sposxl_ = nullptr;
+        posyl_ = sposyl_ = nullptr;
+
+        if (map_) { munmap(map_, map_size_); map_ = nullptr; map_size_ = 0; }
+    }
+
+    void copy(const data& other) noexcept {
+        memcpy(posx_, other.posx_, bodies_*sizeof(float));
+        memcpy(posy_, other.posy_, bodies_*sizeof(float));
+        memcpy(velx_, other.velx_, bodies_*sizeof(float));
+        memcpy(vely_, other.vely_, bodies_*sizeof(float));
+        memcpy(mass_, other.mass_, bodies_*sizeof(float));
+        memcpy(id_, other.id_, bodies_*sizeof(uint32_t));
+
+        if (other.posxl_) {
+            posxl_ = alloc<float>(bodies_); sposxl_ = alloc<float>(bodies_);
+            posyl_ = alloc<float>(bodies_); sposyl_ = alloc<float>(bodies_);
+            memcpy(posxl_, other.posxl_, bodies_*sizeof(float));
+            memcpy(posyl_, other.posyl_, bodies_*sizeof(float));
+        }
+    }
+
+    void steal(data& other) noexcept {
+        posx_ = other.posx_; sposx_ = other.sposx_;
+        posy_ = other.posy_; sposy_ = other.sposy_;
+        velx_ = other.velx_; svelx_ = other.svelx_;
+        vely_ = other.vely_; svely_ = other.svely_;
+        mass_ = other.mass_; smass_ = other.smass_;
+        id_ = other.id_; sid_ = other.sid_;
+        posxl_ = other.posxl_; sposxl_ = other.sposxl_;
+        posyl_ = other.posyl_; sposyl_ = other.sposyl_;
+        map_ = other.map_; map_size_ = other.map_size_;
+        order_ = other.order_;
+
+        other.bodies_ = 0;
+        other.map_ = nullptr;
+        other.map_size_ = 0;
+        other.posx_ = other.sposx_ = nullptr;
+        other.posy_ = other.sposy_ = nullptr;
+        other.velx_ = other.svelx_ = nullptr;
+        other.vely_ = other.svely_ = nullptr;
+        other.mass_ = other.smass_ = nullptr;
+        other.id_ = other.sid_ = nullptr;
+        other.posxl_ = other.sposxl_ = nullptr;
+        other.posyl_ = other.sposyl_ = nullptr;
+    }
+
     public:
 
     // default constructor
@@ -32,105 +132,126 @@ struct data {
         velx_(nullptr),
         vely_(nullptr),
         mass_(nullptr),
+        id_(nullptr),
+        sposx_(nullptr),
+        sposy_(nullptr),
+        svelx_(nullptr),
+        svely_(nullptr),
+        smass_(nullptr),
+        sid_(nullptr),
+        posxl_(nullptr),
+        posyl_(nullptr),
+        sposxl_(nullptr),
+        sposyl_(nullptr),
+        map_(nullptr),
+        map_size_(0),
+        order_(0),
         accx_(matrix()),
         accy_(matrix()) {}
 
     // move constructor
     data(data&& other) noexcept :
         bodies_(other.bodies_),
-        posx_(other.posx_),
-        posy_(other.posy_),
-        velx_(other.velx_),
-        vely_(other.vely_),
-        mass_(other.mass_),
         accx_(other.accx_),
         accy_(other.accy_) {
-            other.bodies_ = 0;
-            other.posx_ = nullptr;
-            other.posy_ = nullptr;
-            other.velx_ = nullptr;
-            other.vely_ = nullptr;
-            other.mass_ = nullptr;
+            steal(other);
         }
 
     // copy constructor
     data(const data& other) noexcept :
         bodies_(other.bodies_),
+        posxl_(nullptr),
+        posyl_(nullptr),
+        sposxl_(nullptr),
+        sposyl_(nullptr),
+        map_(nullptr),
+        map_size_(0),
+        order_(other.order_),
         accx_(other.accx_),
         accy_(other.accy_) {
-            posx_ = (float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(bodies_*sizeof(float)));
-            posy_ = (float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(bodies_*sizeof(float)));
-            velx_ = (float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(bodies_*sizeof(float)));
-            vely_ = (float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(bodies_*sizeof(float)));
-            mass_ = (float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(bodies_*sizeof(float)));
-
-            memcpy(posx_, other.posx_, bodies_*sizeof(float));
-            memcpy(posy_, other.posy_, bodies_*sizeof(float));
-            memcpy(velx_, other.velx_, bodies_*sizeof(float));
-            memcpy(vely_, other.vely_, bodies_*sizeof(float));
-            memcpy(mass_, other.mass_, bodies_*sizeof(float));
+            allocate();
+            copy(other);
     }
 
-    // custom constructor
-    data(size_t n, bool init_acc) :
+    // custom constructor, acc_rows is the number of acceleration rows to allocate (0 for none)
+    data(size_t n, size_t acc_rows) :
+        bodies_(n),
+        posxl_(nullptr),
+        posyl_(nullptr),
+        sposxl_(nullptr),
+        sposyl_(nullptr),
+        map_(nullptr),
+        map_size_(0),
+        order_(0),
+        accx_(acc_rows ? matrix(acc_rows, n) : matrix()),
+        accy_(acc_rows ? matrix(acc_rows, n) : matrix()) {
+            allocate();
+
+            #pragma omp parallel for simd schedule(static)
+            for (size_t i = 0; i < n; i++) { id_[i] = i; }
+        }
+
+    // mapped constructor, arrays point straight into map which is unmapped once data is released,
+    // only the shadows are allocated. Position errors are only given for precise data
+    data(size_t n, size_t acc_rows, void* map, size_t map_size, float* px, float* py, float* vx, float* vy, float* m, uint32_t* id,
+        float* pxl = nullptr, float* pyl = nullptr) :
         bodies_(n),
-        posx_((float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(n*sizeof(float)))),
-        posy_((float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(n*sizeof(float)))),
-        velx_((float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(n*sizeof(float)))),
-        vely_((float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(n*sizeof(float)))),
-        mass_((float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(n*sizeof(float)))),
-        accx_(init_acc ? matrix(omp_get_max_threads(), n) : matrix()),
-        accy_(init_acc ? matrix(omp_get_max_threads(), n) : matrix()) {}
+        posx_(px),
+        posy_(py),
+        velx_(vx),
+        vely_(vy),
+        mass_(m),
+        id_(id),
+        sposx_(alloc<float>(n)),
+        sposy_(alloc<float>(n)),
+        svelx_(alloc<float>(n)),
+        svely_(alloc<float>(n)),
+        smass_(alloc<float>(n)),
+        sid_(alloc<uint32_t>(n)),
+        posxl_(pxl),
+        posyl_(pyl),
+        sposxl_(pxl ? alloc<float>(n) : nullptr),
+        sposyl_(pyl ? alloc<float>(n) : nullptr),
+        map_(map),
+        map_size_(map_size),
+        order_(0),
+        accx_(acc_rows ? matrix(acc_rows, n) : matrix()),
+        accy_(acc_rows ? matrix(acc_rows, n) : matrix()) {}
 
 
     // move operator
     data& operator = (data&& other) noexcept {
+        if (this == &other) { return *this; }
+
+        release();
         bodies_= other.bodies_;
-        posx_ = other.posx_;
-        posy_ = other.posy_;
-        velx_ = other.velx_;
-        vely_ = other.vely_;
-        mass_ = other.mass_;
         accx_ = other.accx_;
         accy_ = other.accy_; 
-
-        other.bodies_ = 0;
-        other.posx_ = nullptr;
-        other.posy_ = nullptr;
-        other.velx_ = nullptr;
-        other.vely_ = nullptr;
-        other.mass_ = nullptr;
+        steal(other);
         return *this;
     }
 
     // copy operator
     data& operator = (const data& other) noexcept {
+        if (this == &other) { return *this; }
+
+        release();
         bodies_ = other.bodies_;
         accx_ = other.accx_;
         accy_ = other.accy_;
 
-        posx_ = (float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(bodies_*sizeof(float)));
-        posy_ = (float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(bodies_*sizeof(float)));
-        velx_ = (float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(bodies_*sizeof(float)));
-        vely_ = (float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(bodies_*sizeof(float)));
-        mass_ = (float*)aligned_alloc(MEM_ALIGNMENT, util::aligned_size(bodies_*sizeof(float)));
-            
-        memcpy(posx_, other.posx_, bodies_*sizeof(float));
-        memcpy(posy_, other.posy_, bodies_*sizeof(float));
-        memcpy(velx_, other.velx_, bodies_*sizeof(float));
-        memcpy(vely_, other.vely_, bodies_*sizeof(float));
-        memcpy(mass_, other.mass_, bodies_*sizeof(float));
+        map_ = nullptr;
+        map_size_ = 0;
+        order_ = other.order_;
+        allocate();
+        copy(other);
         return *this;
     }
 
     // deconstructor
     ~data() {
         bodies_ = 0;
-        if (posx_) { free(posx_); posx_ =  nullptr; }
-        if (posy_) { free(posy_); posy_ =  nullptr; }
-        if (velx_) { free(velx_); velx_ =  nullptr; }
-        if (vely_) { free(vely_); vely_ =  nullptr; }
-        if (mass_) { free(mass_); mass_ =  nullptr; }
+        release();
     }
 
     constexpr inline size_t bodies() const noexcept { return bodies_; }
@@ -146,75 +267,78 @@ struct data {
     inline float* __restrict vely() noexcept { return vely_; }
     inline float* __restrict mass() noexcept { return mass_; }
 
-    matrix& accx() noexcept { return accx_; }
-    matrix& accy() noexcept { return accy_; }
-
-    inline void zero_acc() noexcept { accx_.zero(); accy_.zero(); }
+    /// @brief rounding error of every position, nullptr unless precise
+    const inline float* __restrict posxl() const noexcept { return posxl_; }
+    const inline float* __restrict posyl() const noexcept { return posyl_; }
+    inline float* __restrict posxl() noexcept { return posxl_; }
+    inline float* __restrict posyl() noexcept { return posyl_; }
+    constexpr inline bool precise() const noexcept { return posxl_ != nullptr; }
 
-    inline void sort() noexcept {
-        std::vector<std::pair<float, size_t>> values(bodies_);
+    /// @brief Starts keeping position errors, current positions are taken as exact
+    inline void make_precise() noexcept {
+        if (posxl_) { return; }
+        posxl_ = alloc<float>(bodies_); sposxl_ = alloc<float>(bodies_);
+        posyl_ = alloc<float>(bodies_); sposyl_ = alloc<float>(bodies_);
+        std::fill(posxl_, posxl_+bodies_, 0.0f);
+        std::fill(posyl_, posyl_+bodies_, 0.0f);
+    }
 
-        #pragma omp parallel for simd schedule(static)
-        for (size_t i = 0; i < bodies_; i++) {
-            values[i] = { posx_[i]*posx_[i]+posy_[i]*posy_[i], i };
-        }
+    /// @brief shadow positions, for steps that write new positions while other bodies still read the current ones
+    inline float* __restrict next_posx() noexcept { return sposx_; }
+    inline float* __restrict next_posy() noexcept { return sposy_; }
+    inline float* __restrict next_posxl() noexcept { return sposxl_; }
+    inline float* __restrict next_posyl() noexcept { return sposyl_; }
 
-        std::sort(values.begin(), values.end());
-
-        for (size_t i = 0; i < bodies_-1; i++) {
-            size_t cur = i;
-            size_t next = values[cur].second;
-
-            while (next != i) {
-                std::swap(posx_[cur], posx_[next]);
-                std::swap(posy_[cur], posy_[next]);
-                std::swap(velx_[cur], velx_[next]);
-                std::swap(vely_[cur], vely_[next]);
-                std::swap(mass_[cur], mass_[next]);
-                values[cur].second = cur;
-                cur = next;
-                next = values[cur].second;
-            }
-            values[cur].second = cur;
-        }
+    /// @brief makes the positions written through next_posx and next_posy current
+    inline void swap_pos() noexcept {
+        std::swap(posx_, sposx_);
+        std::swap(posy_, sposy_);
+        std::swap(posxl_, sposxl_);
+        std::swap(posyl_, sposyl_);
     }
 
-    inline void zcurve() noexcept {
-        std::vector<std::pair<uint64_t, size_t>> values(bodies_);
+    /// @brief changes every time bodies are reordered, consumers caching anything by index compare against it
+    constexpr inline uint64_t order() const noexcept { return order_; }
 
-        auto [minx, maxx] = std::minmax_element(posx_, posx_+bodies_);
-        auto [miny, maxy] = std::minmax_element(posy_, posy_+bodies_);
+    /// @brief index each body had at initialization, follows the body through every reorder
+    const inline uint32_t* __restrict id() const noexcept { return id_; }
 
-        float rx = (*maxx > *minx) ? (*maxx - *minx) : 1.0f;
-        float ry = (*maxy > *miny) ? (*maxy - *miny) : 1.0f;
+    matrix& accx() noexcept { return accx_; }
+    matrix& accy() noexcept { return accy_; }
+
+    inline void zero_acc() noexcept { accx_.zero(); accy_.zero(); }
 
+    /// @brief Reorders bodies so the body at idx[i] moves to i, gathers into the shadow arrays then swaps them in
+    /// @param idx Permutation of [0, bodies)
+    inline void permute(const uint32_t* __restrict idx) noexcept {
         #pragma omp parallel for simd schedule(static)
         for (size_t i = 0; i < bodies_; i++) {
-            // get normalized x, y values
-            uint32_t x = (uint32_t)std::min((double)(posx_[i] - *minx) / rx * 0x100000000, (double)0xFFFFFFFFu);
-            uint32_t y = (uint32_t)std::min((double)(posy_[i] - *miny) / ry * 0x100000000, (double)0xFFFFFFFFu);
-            uint64_t code = _pdep_u64((uint64_t)x, 0x5555555555555555ULL) | _pdep_u64((uint64_t)y, 0xAAAAAAAAAAAAAAAAULL);
-
-            values[i] = { code, i };
+            const uint32_t j = idx[i];
+            sposx_[i] = posx_[j];
+            sposy_[i] = posy_[j];
+            svelx_[i] = velx_[j];
+            svely_[i] = vely_[j];
+            smass_[i] = mass_[j];
+            sid_[i] = id_[j];
         }
 
-        std::sort(values.begin(), values.end());
-
-        for (size_t i = 0; i < bodies_-1; i++) {
-            size_t cur = i;
-            size_t next = values[cur].second;
-
-            while (next != i) {
-                std::swap(posx_[cur], posx_[next]);
-                std::swap(posy_[cur], posy_[next]);
-                std::swap(velx_[cur], velx_[next]);
-                std::swap(vely_[cur], vely_[next]);
-                std::swap(mass_[cur], mass_[next]);
-                values[cur].second = cur;
-                cur = next;
-                next = values[cur].second;
+        std::swap(posx_, sposx_);
+        std::swap(posy_, sposy_);
+        std::swap(velx_, svelx_);
+        std::swap(vely_, svely_);
+        std::swap(mass_, smass_);
+        std::swap(id_, sid_);
+
+        if (posxl_) {
+            #pragma omp parallel for simd schedule(static)
+            for (size_t i = 0; i < bodies_; i++) {
+                sposxl_[i] = posxl_[idx[i]];
+                sposyl_[i] = posyl_[idx[i]];
             }
-            values[cur].second = cur;
+
+            std::swap(posxl_, sposxl_);
+            std::swap(posyl_, sposyl_);
         }
+        order_++;
     }
 };
@@ -4,13 +4,8 @@
 
 Defines helper macros and definitions to be used for compilation
 
-MEM_ALIGNMENT : dictates the parameter used for aligned_alloc
+MEM_ALIGNMENT : dictates the parameter used for aligned_alloc, always 64 as the kernels are chosen at runtime
+and the widest of them uses aligned 64 byte loads
 */
 
-#ifdef __AVX512F__
 #define MEM_ALIGNMENT 64
-#elif defined(__AVX2__)
-#define MEM_ALIGNMENT 32
-#else
-#define MEM_ALIGNMENT 32
-#endif
@@ -0,0 +1,154 @@
+/*
+Author: Joey Soroka
+Updated: 10/17/26
+Purpose: Implements the background diagnostics
+Comments: The potential is an all pairs sum like attract_points, so it runs on its own omp team sized
+to leave most of the machine to the simulation. Partial sums are float per body and double across bodies
+*/
+
+#include "diagnostics.hpp"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <omp.h>
+
+#include "../simd/simd.hpp"
+
+double diagnostics::report::energy_drift() const noexcept {
+    const double e0 = first.energy();
+    return e0 != 0.0 ? (last.energy() - e0) / std::abs(e0) : 0.0;
+}
+
+double diagnostics::report::momentum_drift() const noexcept {
+    const double dx = last.px - first.px;
+    const double dy = last.py - first.py;
+    return first.scale > 0.0 ? std::sqrt(dx*dx + dy*dy) / first.scale : 0.0;
+}
+
+double diagnostics::report::angular_drift() const noexcept {
+    return first.lz != 0.0 ? (last.lz - first.lz) / std::abs(first.lz) : 0.0;
+}
+
+diagnostics::diagnostics(size_t bodies, size_t every, size_t threads, bool precise) :
+    bodies_(bodies),
+    every_(every),
+    threads_(std::max<size_t>(threads, 1)),
+    busy_(false),
+    done_(false),
+    step_(0),
+    px_(bodies),
+    py_(bodies),
+    vx_(bodies),
+    vy_(bodies),
+    m_(bodies),
+    pxl_(precise ? bodies : 0),
+    pyl_(precise ? bodies : 0) {
+        worker_ = std::thread(&diagnostics::work_loop, this);
+    }
+
+diagnostics::~diagnostics() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+    }
+    cv_.notify_all();
+    worker_.join();
+}
+
+bool diagnostics::record(const data& d, size_t step) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (busy_) { report_.skipped++; return false; }
+    }
+
+    // the worker only reads the buffers while busy
+    const size_t bytes = bodies_ * sizeof(float);
+    memcpy(px_.data(), d.posx(), bytes);
+    memcpy(py_.data(), d.posy(), bytes);
+    memcpy(vx_.data(), d.velx(), bytes);
+    memcpy(vy_.data(), d.vely(), bytes);
+    memcpy(m_.data(), d.mass(), bytes);
+    if (!pxl_.empty()) {
+        memcpy(pxl_.data(), d.posxl(), bytes);
+        memcpy(pyl_.data(), d.posyl(), bytes);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        step_ = step;
+        busy_ = true;
+    }
+    cv_.notify_all();
+    return true;
+}
+
+void diagnostics::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return !busy_; });
+}
+
+diagnostics::report diagnostics::latest() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return report_;
+}
+
+void diagnostics::work_loop() {
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return done_ || busy_; });
+            if (!busy_) { break; }
+        }
+
+        auto s = std::chrono::high_resolution_clock::now();
+        sample smp = evaluate();
+        auto time = std::chrono::high_resolution_clock::now() - s;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            smp.step = step_;
+            if (report_.samples == 0) { report_.first = smp; }
+            report_.last = smp;
+            report_.samples++;
+            report_.time = time;
+            busy_ = false;
+        }
+        cv_.notify_all();
+    }
+}
+
+diagnostics::sample diagnostics::evaluate() const noexcept {
+    const size_t n = bodies_;
+    const float* __restrict px = px_.data();
+    const float* __restrict py = py_.data();
+    const float* __restrict vx = vx_.data();
+    const float* __restrict vy = vy_.data();
+    const float* __restrict ma = m_.data();
+
+    double kinetic = 0.0, mx = 0.0, my = 0.0, lz = 0.0, scale = 0.0;
+
+    #pragma omp parallel for simd num_threads(threads_) schedule(static) reduction(+:kinetic, mx, my, lz, scale)
+    for (size_t i = 0; i < n; i++) {
+        const double m = ma[i];
+        const double v2 = (double)vx[i]*vx[i] + (double)vy[i]*vy[i];
+        kinetic += 0.5 * m * v2;
+        mx += m * vx[i];
+        my += m * vy[i];
+        lz += m * ((double)px[i]*vy[i] - (double)py[i]*vx[i]);
+        scale += m * std::sqrt(v2);
+    }
+
+    sample s;
+    s.kinetic = kinetic;
+    s.potential = potential();
+    s.px = mx;
+    s.py = my;
+    s.lz = lz;
+    s.scale = scale;
+    return s;
+}
+
+/// @brief Sum of -m1 m2 / r over every pair, see simd::table
+double diagnostics::potential() const noexcept {
+    return simd::active().potential[!pxl_.empty()](px_.data(), py_.data(), pxl_.data(), pyl_.data(), m_.data(), bodies_, threads_);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "../data/data.hpp"
+
+/// @brief Conserved quantities of the system computed on a background thread, the simulation only copies
+/// positions, velocities and masses into a buffer. A step arriving while the previous one is still being
+/// evaluated is skipped rather than waited on, so diagnostics never slow the simulation down
+struct diagnostics {
+    public:
+    /// @brief conserved quantities at one step, potential uses the same softening as the force kernels
+    struct sample {
+        size_t step = 0;
+        double kinetic = 0.0;
+        double potential = 0.0;
+        double px = 0.0;
+        double py = 0.0;
+        double lz = 0.0;
+        double scale = 0.0;     // sum of m |v|, what momentum drift is measured against
+
+        inline double energy() const noexcept { return kinetic + potential; }
+        inline double virial() const noexcept { return potential != 0.0 ? 2.0 * kinetic / -potential : 0.0; }
+    };
+
+    /// @brief first and latest sample, drifts are relative to the first
+    struct report {
+        sample first;
+        sample last;
+        size_t samples = 0;
+        size_t skipped = 0;
+        std::chrono::nanoseconds time{0};
+
+        double energy_drift() const noexcept;
+        double momentum_drift() const noexcept;
+        double angular_drift() const noexcept;
+    };
+
+    // custom constructor, threads is the size of the team evaluating the potential and precise copies
+    // the position errors of precise data with the positions
+    diagnostics(size_t bodies, size_t every, size_t threads, bool precise);
+
+    diagnostics(const diagnostics&) = delete;
+    diagnostics& operator = (const diagnostics&) = delete;
+
+    // deconstructor, finishes the sample being evaluated before returning
+    ~diagnostics();
+
+    inline bool due(size_t step) const noexcept { return every_ && step % every_ == 0; }
+
+    /// @brief Copies the current state for evaluation unless the previous step is still being evaluated
+    /// @param d Simulation data
+    /// @param step Step the state belongs to
+    /// @return Whether the step was taken
+    bool record(const data& d, size_t step);
+
+    /// @brief Blocks until the step being evaluated is done
+    void flush();
+
+    /// @brief safe to call while the evaluation runs, samples is 0 until the first one is done
+    report latest();
+
+    private:
+    size_t bodies_;
+    size_t every_;
+    size_t threads_;
+    bool busy_;
+    bool done_;
+    size_t step_;
+    std::vector<float> px_, py_, vx_, vy_, m_;
+    std::vector<float> pxl_, pyl_;     // empty unless precise
+    report report_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::thread worker_;
+
+    void work_loop();
+    sample evaluate() const noexcept;
+    double potential() const noexcept;
+};
@@ -0,0 +1,479 @@
+/*
+Author: Joey Soroka
+Updated: 10/17/26
+Purpose: Implements the fast multipole method over the radix tree
+Comments: The upward pass climbs from the unsplit cells to the root like radixtree::build_nodes, the downward
+pass is a single recursion from the root that interacts each cell with its list of sources, hands its local
+expansion to its children and spawns tasks for large subtrees
+*/
+
+#include "fmm.hpp"
+#include <algorithm>
+#include <cmath>
+#include <omp.h>
+
+// subtrees with more bodies than this are handed to another thread
+static constexpr size_t task_bodies = 4096;
+
+fmm::fmm(size_t order, float theta) : theta_(theta), d_(nullptr), t_(nullptr), ax_(nullptr), ay_(nullptr) {
+    // tables cover one order past the largest expansion, used by derivatives in m2p
+    const size_t p = max_order + 1;
+    pa_.resize(terms(p));
+    pb_.resize(terms(p));
+    for (size_t a = 0; a <= p; a++) {
+        for (size_t b = 0; a+b <= p; b++) { pa_[idx(a, b)] = a; pb_[idx(a, b)] = b; }
+    }
+
+    ifact_.resize(p+1);
+    ifact_[0] = 1.0;
+    for (size_t k = 1; k <= p; k++) { ifact_[k] = ifact_[k-1] / k; }
+
+    set_order(order);
+}
+
+void fmm::set_order(size_t order) noexcept {
+    order_ = std::clamp<size_t>(order, 1, max_order);
+    terms_ = terms(order_);
+}
+
+size_t fmm::evaluate(const data& d, const radixtree& t, float* __restrict ax, float* __restrict ay) {
+    d_ = &d;
+    t_ = &t;
+    ax_ = ax;
+    ay_ = ay;
+
+    const size_t n = d.bodies();
+    std::fill(ax, ax+n, 0.0f);
+    std::fill(ay, ay+n, 0.0f);
+
+    // a single body has no tree and no forces
+    if (t.size() == 0) { return 0; }
+
+    build_cells();
+    upward();
+
+    size_t interactions = 0;
+
+    #pragma omp parallel
+    #pragma omp single
+    {
+        std::vector<uint32_t> list = { 0 };
+        interactions = downward(0, list);
+    }
+
+    return interactions;
+}
+
+/// @brief Numbers the cells in node order and fills in their centers and radii
+void fmm::build_cells() {
+    const size_t nodes = t_->size();
+    const uint32_t* __restrict parent = t_->parent();
+
+    cell_.resize(nodes);
+    node_.resize(nodes);
+
+    auto is_cell = [&](size_t i) { return i == 0 || split(parent[i]); };
+
+    // parallel exclusive scan over the cell flags, each thread numbers a contiguous chunk of nodes
+    std::vector<size_t> offsets(omp_get_max_threads() + 1, 0);
+    size_t cells = 0;
+
+    #pragma omp parallel
+    {
+        const size_t tid = omp_get_thread_num();
+        const size_t nt = omp_get_num_threads();
+        const size_t lo = nodes * tid / nt;
+        const size_t hi = nodes * (tid+1) / nt;
+
+        size_t local = 0;
+        for (size_t i = lo; i < hi; i++) { local += is_cell(i); }
+        offsets[tid+1] = local;
+
+        #pragma omp barrier
+        #pragma omp single
+        {
+            for (size_t k = 0; k < nt; k++) { offsets[k+1] += offsets[k]; }
+            cells = offsets[nt];
+        }
+
+        size_t s = offsets[tid];
+        for (size_t i = lo; i < hi; i++) {
+            if (is_cell(i)) { cell_[i] = s; node_[s] = i; s++; }
+            else { cell_[i] = radixtree::none; }
+        }
+    }
+
+    cx_.resize(cells);
+    cy_.resize(cells);
+    r_.resize(cells);
+    flags_.resize(cells);
+    m_.resize(cells * terms_);
+    l_.resize(cells * terms_);
+
+    #pragma omp parallel for schedule(static)
+    for (size_t c = 0; c < cells; c++) {
+        const uint32_t node = node_[c];
+
+        // expansions are centered on the center of mass, the radius bounds every body from it
+        const double x = t_->cx()[node];
+        const double y = t_->cy()[node];
+        const double rx = std::max(x - t_->minx()[node], t_->maxx()[node] - x);
+        const double ry = std::max(y - t_->miny()[node], t_->maxy()[node] - y);
+
+        cx_[c] = x;
+        cy_[c] = y;
+        r_[c] = std::sqrt(rx*rx + ry*ry);
+
+        // split cells wait for their child cells, bodies among their children count as already arrived
+        flags_[c] = split(node) ? ((t_->left()[node] & radixtree::leaf) != 0) + ((t_->right()[node] & radixtree::leaf) != 0) : 0;
+
+        std::fill(&m_[c*terms_], &m_[(c+1)*terms_], 0.0);
+        std::fill(&l_[c*terms_], &l_[(c+1)*terms_], 0.0);
+    }
+}
+
+/// @brief Builds multipoles from bodies in every unsplit cell then climbs towards the root, the second
+/// child to arrive at a cell translates both children into it
+void fmm::upward() {
+    const size_t cells = cx_.size();
+    const uint32_t* __restrict parent = t_->parent();
+    const uint32_t* __restrict left = t_->left();
+    const uint32_t* __restrict right = t_->right();
+
+    #pragma omp parallel for schedule(dynamic, 64)
+    for (size_t c = 0; c < cells; c++) {
+        const uint32_t node = node_[c];
+        if (split(node)) { continue; }
+
+        p2m(c, t_->first()[node], t_->last()[node]);
+
+        uint32_t p = parent[node];
+        while (p != radixtree::none) {
+            const uint32_t pc = cell_[p];
+            if (__atomic_fetch_add(&flags_[pc], 1, __ATOMIC_ACQ_REL) == 0) { break; }
+
+            for (const uint32_t ch : { left[p], right[p] }) {
+                if (ch & radixtree::leaf) {
+                    const uint32_t j = ch & ~radixtree::leaf;
+                    p2m(pc, j, j+1);
+                } else {
+                    m2m(pc, cell_[ch]);
+                }
+            }
+
+            p = parent[p];
+        }
+    }
+}
+
+/// @brief Interacts cell c with every source in list, then passes its local expansion and the sources it could
+/// not resolve on to its children. Unsplit cells resolve everything and evaluate their local expansion
+/// @return Number of interactions
+size_t fmm::downward(uint32_t c, std::vector<uint32_t>& list) {
+    const uint32_t node = node_[c];
+    const bool terminal = !split(node);
+    const uint32_t first = t_->first()[node];
+    const uint32_t last = t_->last()[node];
+    const uint32_t* __restrict left = t_->left();
+    const uint32_t* __restrict right = t_->right();
+    const double thetasq = (double)theta_ * theta_;
+
+    std::vector<uint32_t> defer;
+    size_t interactions = 0;
+
+    while (!list.empty()) {
+        const uint32_t s = list.back();
+        list.pop_back();
+
+        // single body, summed once this cell can no longer be split
+        if (s & radixtree::leaf) {
+            const uint32_t j = s & ~radixtree::leaf;
+            if (terminal) { p2p(first, last, j, j+1); interactions += last - first; }
+            else { defer.push_back(s); }
+            continue;
+        }
+
+        const uint32_t sc = cell_[s];
+        const double dx = cx_[c] - cx_[sc];
+        const double dy = cy_[c] - cy_[sc];
+        const double rr = r_[c] + r_[sc];
+
+        if (rr*rr < thetasq * (dx*dx + dy*dy)) {
+            m2l(c, sc);
+            interactions++;
+        } else if (terminal && !split(s)) {
+            p2p(first, last, t_->first()[s], t_->last()[s]);
+            interactions += (last - first) * count(s);
+        } else if (!terminal && (!split(s) || r_[sc] <= r_[c])) {
+            defer.push_back(s);
+        } else {
+            list.push_back(left[s]);
+            list.push_back(right[s]);
+        }
+    }
+
+    if (terminal) {
+        l2p(c, first, last);
+        return interactions + (last - first);
+    }
+
+    size_t sub[2] = { 0, 0 };
+    const uint32_t children[2] = { left[node], right[node] };
+
+    for (size_t k = 0; k < 2; k++) {
+        const uint32_t ch = children[k];
+
+        if (ch & radixtree::leaf) {
+            std::vector<uint32_t> rest = defer;
+            sub[k] = body(ch & ~radixtree::leaf, &l_[c*terms_], cx_[c], cy_[c], rest);
+            continue;
+        }
+
+        l2l(c, cell_[ch]);
+
+        #pragma omp task default(shared) firstprivate(ch, k, defer) if(count(ch) > task_bodies)
+        sub[k] = downward(cell_[ch], defer);
+    }
+
+    #pragma omp taskwait
+    return interactions + sub[0] + sub[1];
+}
+
+/// @brief Resolves a body that is a direct child of a split cell, it takes the local expansion of that cell
+/// and walks the remaining sources on its own
+/// @return Number of interactions
+size_t fmm::body(uint32_t i, const double* l, double lx, double ly, std::vector<uint32_t>& list) {
+    const float* __restrict px = d_->posx();
+    const float* __restrict py = d_->posy();
+    const float* __restrict ma = d_->mass();
+    const double thetasq = (double)theta_ * theta_;
+    const double x = px[i];
+    const double y = py[i];
+
+    double ax = 0.0;
+    double ay = 0.0;
+    size_t interactions = 1;
+
+    // local expansion of the parent evaluated at the body
+    double t[terms(max_order)];
+    powers(x - lx, y - ly, order_-1, t);
+    for (size_t k = 0; k < terms(order_-1); k++) {
+        ax += l[idx(pa_[k]+1, pb_[k])] * t[k];
+        ay += l[idx(pa_[k], pb_[k]+1)] * t[k];
+    }
+
+    while (!list.empty()) {
+        const uint32_t s = list.back();
+        list.pop_back();
+
+        if (s & radixtree::leaf) {
+            const uint32_t j = s & ~radixtree::leaf;
+            const double dx = px[j] - x;
+            const double dy = py[j] - y;
+            const double inv = 1.0 / std::sqrt(1e-12 + dx*dx + dy*dy);
+            ax += ma[j] * dx * inv*inv*inv;
+            ay += ma[j] * dy * inv*inv*inv;
+            interactions++;
+            continue;
+        }
+
+        const uint32_t sc = cell_[s];
+        const double dx = x - cx_[sc];
+        const double dy = y - cy_[sc];
+
+        if (r_[sc]*r_[sc] < thetasq * (dx*dx + dy*dy)) {
+            m2p(sc, x, y, ax, ay);
+            interactions++;
+        } else if (!split(s)) {
+            p2p(i, i+1, t_->first()[s], t_->last()[s]);
+            interactions += count(s);
+        } else {
+            list.push_back(t_->left()[s]);
+            list.push_back(t_->right()[s]);
+        }
+    }
+
+    ax_[i] += ax;
+    ay_[i] += ay;
+    return interactions;
+}
+
+void fmm::p2m(uint32_t c, uint32_t first, uint32_t last) noexcept {
+    const float* __restrict px = d_->posx();
+    const float* __restrict py = d_->posy();
+    const float* __restrict ma = d_->mass();
+    double* __restrict m = &m_[c*terms_];
+
+    double t[terms(max_order)];
+    for (uint32_t j = first; j < last; j++) {
+        powers(px[j] - cx_[c], py[j] - cy_[c], order_, t);
+        for (size_t k = 0; k < terms_; k++) { m[k] += ma[j] * t[k]; }
+    }
+}
+
+void fmm::m2m(uint32_t parent, uint32_t child) noexcept {
+    const double* __restrict mc = &m_[child*terms_];
+    double* __restrict mp = &m_[parent*terms_];
+
+    double t[terms(max_order)];
+    powers(cx_[child] - cx_[parent], cy_[child] - cy_[parent], order_, t);
+
+    for (size_t k = 0; k < terms_; k++) {
+        const size_t a = pa_[k];
+        const size_t b = pb_[k];
+        double sum = 0.0;
+        for (size_t i = 0; i <= a; i++) {
+            for (size_t j = 0; j <= b; j++) { sum += mc[idx(i, j)] * t[idx(a-i, b-j)]; }
+        }
+        mp[k] += sum;
+    }
+}
+
+void fmm::m2l(uint32_t target, uint32_t source) noexcept {
+    const double* __restrict m = &m_[source*terms_];
+    double* __restrict l = &l_[target*terms_];
+
+    double dr[terms(max_order)];
+    derivatives(cx_[target] - cx_[source], cy_[target] - cy_[source], order_, dr);
+
+    for (size_t n = 0; n < terms_; n++) {
+        const size_t na = pa_[n];
+        const size_t nb = pb_[n];
+        double sum = 0.0;
+        for (size_t k = 0; k < terms(order_ - na - nb); k++) {
+            const double sign = (pa_[k] + pb_[k]) & 1 ? -1.0 : 1.0;
+            sum += sign * m[k] * dr[idx(pa_[k]+na, pb_[k]+nb)];
+        }
+        l[n] += sum;
+    }
+}
+
+void fmm::l2l(uint32_t parent, uint32_t child) noexcept {
+    const double* __restrict lp = &l_[parent*terms_];
+    double* __restrict lc = &l_[child*terms_];
+
+    double t[terms(max_order)];
+    powers(cx_[child] - cx_[parent], cy_[child] - cy_[parent], order_, t);
+
+    for (size_t n = 0; n < terms_; n++) {
+        const size_t na = pa_[n];
+        const size_t nb = pb_[n];
+        double sum = 0.0;
+        for (size_t k = 0; k < terms(order_ - na - nb); k++) {
+            sum += lp[idx(pa_[k]+na, pb_[k]+nb)] * t[k];
+        }
+        lc[n] += sum;
+    }
+}
+
+void fmm::l2p(uint32_t c, uint32_t first, uint32_t last) noexcept {
+    const float* __restrict px = d_->posx();
+    const float* __restrict py = d_->posy();
+    const double* __restrict l = &l_[c*terms_];
+
+    // the gradient of the local expansion drops one order
+    double t[terms(max_order)];
+    for (uint32_t i = first; i < last; i++) {
+        powers(px[i] - cx_[c], py[i] - cy_[c], order_-1, t);
+
+        double ax = 0.0;
+        double ay = 0.0;
+        for (size_t k = 0; k < terms(order_-1); k++) {
+            ax += l[idx(pa_[k]+1, pb_[k])] * t[k];
+            ay += l[idx(pa_[k], pb_[k]+1)] * t[k];
+        }
+
+        ax_[i] += ax;
+        ay_[i] += ay;
+    }
+}
+
+void fmm::m2p(uint32_t c, double x, double y, double& ax, double& ay) const noexcept {
+    const double* __restrict m = &m_[c*terms_];
+
+    double dr[terms(max_order+1)];
+    derivatives(x - cx_[c], y - cy_[c], order_+1, dr);
+
+    for (size_t k = 0; k < terms_; k++) {
+        const double sign = (pa_[k] + pb_[k]) & 1 ? -1.0 : 1.0;
+        ax += sign * m[k] * dr[idx(pa_[k]+1, pb_[k])];
+        ay += sign * m[k] * dr[idx(pa_[k], pb_[k]+1)];
+    }
+}
+
+void fmm::p2p(uint32_t tfirst, uint32_t tlast, uint32_t sfirst, uint32_t slast) noexcept {
+    const float* __restrict px = d_->posx();
+    const float* __restrict py = d_->posy();
+    const float* __restrict ma = d_->mass();
+
+    // same softened kernel as the direct solvers, self interaction is zero as dx and dy are zero
+    for (uint32_t i = tfirst; i < tlast; i++) {
+        const float p1x = px[i];
+        const float p1y = py[i];
+        float a1x = 0.0f;
+        float a1y = 0.0f;
+
+        #pragma omp simd reduction(+:a1x, a1y)
+        for (uint32_t j = sfirst; j < slast; j++) {
+            const float dx = px[j] - p1x;
+            const float dy = py[j] - p1y;
+            const float dsq = 1e-12f + (dx*dx) + (dy*dy);
+
+            const float inv = 1.0f / std::sqrt(dsq);
+            const float inv3 = ma[j] * inv * inv * inv;
+            a1x += dx * inv3;
+            a1y += dy * inv3;
+        }
+
+        ax_[i] += a1x;
+        ay_[i] += a1y;
+    }
+}
+
+/// @brief Partial derivatives of 1/r at (x, y) up to order p, d^a/dx^a d^b/dy^b is written to out[idx(a, b)].
+/// As 1/r = f(x^2 + y^2) every derivative is a finite sum over derivatives of f, which are closed form
+void fmm::derivatives(double x, double y, size_t p, double* __restrict out) const noexcept {
+    const double rsq = x*x + y*y;
+    const double rinv = 1.0 / std::sqrt(rsq);
+
+    // h[n] = 2^n f^(n)(r^2) = (-1)^n (2n-1)!! r^-(2n+1)
+    double h[max_order + 2];
+    h[0] = rinv;
+    for (size_t n = 1; n <= p; n++) { h[n] = -h[n-1] * (2*n - 1) / rsq; }
+
+    double xp[max_order + 2];
+    double yp[max_order + 2];
+    xp[0] = yp[0] = 1.0;
+    for (size_t k = 1; k <= p; k++) { xp[k] = xp[k-1] * x; yp[k] = yp[k-1] * y; }
+
+    // c(a, i) = a! / (i! (a-2i)! 2^i), from expanding d^a/dx^a f(x^2 + y^2)
+    auto coef = [&](size_t a, size_t i) {
+        return ifact_[i] * ifact_[a - 2*i] / (ifact_[a] * (double)(1u << i));
+    };
+
+    for (size_t k = 0; k < terms(p); k++) {
+        const size_t a = pa_[k];
+        const size_t b = pb_[k];
+        double sum = 0.0;
+        for (size_t i = 0; 2*i <= a; i++) {
+            const double ca = coef(a, i) * xp[a - 2*i];
+            for (size_t j = 0; 2*j <= b; j++) {
+                sum += ca * coef(b, j) * yp[b - 2*j] * h[a + b - i - j];
+            }
+        }
+        out[k] = sum;
+    }
+}
+
+/// @brief Scaled monomials x^a y^b / (a! b!) up to order p, written to out[idx(a, b)]
+void fmm::powers(double x, double y, size_t p, double* __restrict out) const noexcept {
+    double xa[max_order + 2];
+    double yb[max_order + 2];
+    xa[0] = yb[0] = 1.0;
+    for (size_t k = 1; k <= p; k++) {
+        xa[k] = xa[k-1] * x / k;
+        yb[k] = yb[k-1] * y / k;
+    }
+
+    for (size_t k = 0; k < terms(p); k++) { out[k] = xa[pa_[k]] * yb[pb_[k]]; }
+}
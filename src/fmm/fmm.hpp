@@ -0,0 +1,76 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../data/data.hpp"
+#include "../radixtree/radixtree.hpp"
+
+/// @brief Fast multipole method over the radix tree. Bodies are confined to the plane but still attract with
+/// the 3D 1/r potential, so expansions are cartesian Taylor series in the two plane coordinates rather than the
+/// complex series of the 2D log kernel. Expansion coefficients are indexed by (a, b), the powers of x and y
+struct fmm {
+    public:
+    static constexpr size_t max_order = 12;
+
+    // default constructor
+    fmm() : fmm(4, 0.5f) {}
+
+    // custom constructor, order is clamped to [1, max_order] and theta is the opening criterion
+    fmm(size_t order, float theta);
+
+    /// @brief Computes the acceleration of every body, the tree must be built over the current order of d
+    /// @param d Simulation data
+    /// @param t Tree over d
+    /// @param ax Output accelerations along x
+    /// @param ay Output accelerations along y
+    /// @return Number of body pairs summed directly plus expansions evaluated or translated across the tree
+    size_t evaluate(const data& d, const radixtree& t, float* __restrict ax, float* __restrict ay);
+
+    constexpr size_t order() const noexcept { return order_; }
+    void set_order(size_t order) noexcept;
+
+    private:
+    size_t order_;
+    size_t terms_;
+    float theta_;
+
+    // tables over the (a, b) terms of the highest order used, derivatives go one order past the expansions
+    std::vector<uint8_t> pa_, pb_;
+    std::vector<double> ifact_;
+
+    // cells are the nodes the traversal can reach, the root and every node whose parent is split
+    std::vector<uint32_t> cell_;
+    std::vector<uint32_t> node_;
+    std::vector<uint32_t> flags_;
+    std::vector<double> cx_, cy_, r_;
+    std::vector<double> m_, l_;
+
+    // inputs of the current evaluation
+    const data* d_;
+    const radixtree* t_;
+    float* ax_;
+    float* ay_;
+
+    static constexpr size_t terms(size_t p) noexcept { return (p+1) * (p+2) / 2; }
+    static constexpr size_t idx(size_t a, size_t b) noexcept { return (a+b) * (a+b+1) / 2 + b; }
+
+    inline size_t count(uint32_t node) const noexcept { return t_->last()[node] - t_->first()[node]; }
+    inline bool split(uint32_t node) const noexcept { return count(node) > radixtree::leaf_size; }
+
+    void build_cells();
+    void upward();
+    size_t downward(uint32_t c, std::vector<uint32_t>& list);
+    size_t body(uint32_t i, const double* l, double lx, double ly, std::vector<uint32_t>& list);
+
+    void p2m(uint32_t c, uint32_t first, uint32_t last) noexcept;
+    void m2m(uint32_t parent, uint32_t child) noexcept;
+    void m2l(uint32_t target, uint32_t source) noexcept;
+    void l2l(uint32_t parent, uint32_t child) noexcept;
+    void l2p(uint32_t c, uint32_t first, uint32_t last) noexcept;
+    void m2p(uint32_t c, double x, double y, double& ax, double& ay) const noexcept;
+    void p2p(uint32_t tfirst, uint32_t tlast, uint32_t sfirst, uint32_t slast) noexcept;
+
+    void derivatives(double x, double y, size_t p, double* __restrict out) const noexcept;
+    void powers(double x, double y, size_t p, double* __restrict out) const noexcept;
+};
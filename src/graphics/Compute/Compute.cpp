@@ -0,0 +1,321 @@
+#include "Compute.hpp"
+
+#ifdef NBODY_COMPUTE
+// compiled by cmake into the build tree, which is passed as an embed directory
+constexpr const unsigned char Compute::shader_bytes[] = {
+    #embed "nbody.spv"
+};
+constexpr const size_t Compute::shader_size = sizeof(shader_bytes);
+#else
+constexpr const unsigned char Compute::shader_bytes[] = { 0 };
+constexpr const size_t Compute::shader_size = 0;
+#endif
+
+void Compute::init(const data& d, const LogicalDevice& ld, const PhysicalDevice& pd, const MassBuffer& masses) {
+    if (shader_size == 0) {
+        throw std::runtime_error("built without slangc, the gpu solver is unavailable");
+    }
+
+    this->ld = &ld;
+    count = d.bodies();
+    state = 0;
+    vk::DeviceSize size = d.bodies() * sizeof(float);
+
+    constexpr const vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst | vk::BufferUsageFlagBits::eTransferSrc;
+    constexpr const vk::MemoryPropertyFlags properties = vk::MemoryPropertyFlagBits::eDeviceLocal;
+
+    for (uint32_t i = 0; i < 2 + SLOTS; i++) {
+        createBuffer(ld, pd, size, usage, properties, xBuf[i], xMem[i]);
+        createBuffer(ld, pd, size, usage, properties, yBuf[i], yMem[i]);
+    }
+    createBuffer(ld, pd, size, usage, properties, vxBuf, vxMem);
+    createBuffer(ld, pd, size, usage, properties, vyBuf, vyMem);
+
+    commandPool = vk::raii::CommandPool(ld, vk::CommandPoolCreateInfo {
+        .flags            = vk::CommandPoolCreateFlagBits::eResetCommandBuffer,
+        .queueFamilyIndex = ld.QueueIdx()
+    });
+
+    commandBuffers = vk::raii::CommandBuffers(ld, vk::CommandBufferAllocateInfo {
+        .commandPool        = *commandPool,
+        .level              = vk::CommandBufferLevel::ePrimary,
+        .commandBufferCount = 1
+    });
+
+    fence = vk::raii::Fence(ld, vk::FenceCreateInfo {});
+
+    init_upload(d, pd, masses);
+    init_descriptors(masses);
+    init_pipeline();
+}
+
+void Compute::init_upload(const data& d, const PhysicalDevice& pd, const MassBuffer& masses) {
+    const vk::DeviceSize size = count * sizeof(float);
+
+    // masses first so the mass buffer can copy from offset 0, then positions and velocities
+    vk::raii::Buffer       staging = nullptr;
+    vk::raii::DeviceMemory stagingMem = nullptr;
+    createBuffer(*ld, pd, 5 * size, vk::BufferUsageFlagBits::eTransferSrc,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, staging, stagingMem);
+
+    auto* mapped = static_cast<uint8_t*>(stagingMem.mapMemory(0, 5 * size));
+    memcpy(mapped + 0 * size, d.mass(), size);
+    memcpy(mapped + 1 * size, d.posx(), size);
+    memcpy(mapped + 2 * size, d.posy(), size);
+    memcpy(mapped + 3 * size, d.velx(), size);
+    memcpy(mapped + 4 * size, d.vely(), size);
+    stagingMem.unmapMemory();
+
+    const auto& cmd = commandBuffers[0];
+    cmd.begin(vk::CommandBufferBeginInfo { .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+
+    masses.record_upload(cmd, staging);
+
+    // both states and every render slot start from the initial positions
+    for (uint32_t i = 0; i < 2 + SLOTS; i++) {
+        cmd.copyBuffer(*staging, *xBuf[i], vk::BufferCopy { .srcOffset = 1 * size, .dstOffset = 0, .size = size });
+        cmd.copyBuffer(*staging, *yBuf[i], vk::BufferCopy { .srcOffset = 2 * size, .dstOffset = 0, .size = size });
+    }
+    cmd.copyBuffer(*staging, *vxBuf, vk::BufferCopy { .srcOffset = 3 * size, .dstOffset = 0, .size = size });
+    cmd.copyBuffer(*staging, *vyBuf, vk::BufferCopy { .srcOffset = 4 * size, .dstOffset = 0, .size = size });
+
+    const vk::MemoryBarrier2 after {
+        .srcStageMask  = vk::PipelineStageFlagBits2::eCopy,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask  = vk::PipelineStageFlagBits2::eVertexShader | vk::PipelineStageFlagBits2::eComputeShader,
+        .dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite
+    };
+    cmd.pipelineBarrier2(vk::DependencyInfo { .memoryBarrierCount = 1, .pMemoryBarriers = &after });
+
+    cmd.end();
+    submit(cmd);
+}
+
+void Compute::init_descriptors(const MassBuffer& masses) {
+    vk::DescriptorPoolSize poolSize { .type = vk::DescriptorType::eStorageBuffer, .descriptorCount = 7 * 2 };
+
+    descriptorPool = vk::raii::DescriptorPool(*ld, vk::DescriptorPoolCreateInfo {
+        .flags         = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
+        .maxSets       = 2,
+        .poolSizeCount = 1,
+        .pPoolSizes    = &poolSize,
+    });
+
+    std::array<vk::DescriptorSetLayoutBinding, 7> bindings;
+    for (uint32_t i = 0; i < bindings.size(); i++) {
+        bindings[i] = { i, vk::DescriptorType::eStorageBuffer, 1, vk::ShaderStageFlagBits::eCompute, nullptr };
+    }
+
+    descriptorSetLayout = vk::raii::DescriptorSetLayout(*ld, vk::DescriptorSetLayoutCreateInfo {
+        .bindingCount = bindings.size(),
+        .pBindings    = bindings.data()
+    });
+
+    std::array<vk::DescriptorSetLayout, 2> layouts = { *descriptorSetLayout, *descriptorSetLayout };
+    descriptorSets = ld->Device().allocateDescriptorSets(vk::DescriptorSetAllocateInfo {
+        .descriptorPool     = *descriptorPool,
+        .descriptorSetCount = layouts.size(),
+        .pSetLayouts        = layouts.data()
+    });
+
+    // set s reads state s and writes the other one
+    const vk::DescriptorBufferInfo vx { *vxBuf, 0, count * sizeof(float) };
+    const vk::DescriptorBufferInfo vy { *vyBuf, 0, count * sizeof(float) };
+    const vk::DescriptorBufferInfo m = masses.Info();
+
+    for (size_t s = 0; s < 2; s++) {
+        const std::array<vk::DescriptorBufferInfo, 7> infos = {
+            vk::DescriptorBufferInfo { *xBuf[s], 0, count * sizeof(float) },
+            vk::DescriptorBufferInfo { *yBuf[s], 0, count * sizeof(float) },
+            vk::DescriptorBufferInfo { *xBuf[s ^ 1], 0, count * sizeof(float) },
+            vk::DescriptorBufferInfo { *yBuf[s ^ 1], 0, count * sizeof(float) },
+            vx, vy, m
+        };
+
+        std::array<vk::WriteDescriptorSet, 7> writes;
+        for (uint32_t i = 0; i < writes.size(); i++) {
+            writes[i] = {
+                .dstSet          = *descriptorSets[s],
+                .dstBinding      = i,
+                .dstArrayElement = 0,
+                .descriptorCount = 1,
+                .descriptorType  = vk::DescriptorType::eStorageBuffer,
+                .pBufferInfo     = &infos[i],
+            };
+        }
+
+        ld->Device().updateDescriptorSets(writes, {});
+    }
+}
+
+void Compute::init_pipeline() {
+    vk::ShaderModuleCreateInfo moduleInfo {
+        .codeSize = shader_size,
+        .pCode    = reinterpret_cast<const uint32_t*>(shader_bytes)
+    };
+    vk::raii::ShaderModule shaderModule{*ld, moduleInfo};
+
+    // float dt + uint count = 8 bytes
+    vk::PushConstantRange pushRange {
+        .stageFlags = vk::ShaderStageFlagBits::eCompute,
+        .offset     = 0,
+        .size       = 8
+    };
+
+    pipelineLayout = vk::raii::PipelineLayout(*ld, vk::PipelineLayoutCreateInfo {
+        .setLayoutCount         = 1,
+        .pSetLayouts            = &*descriptorSetLayout,
+        .pushConstantRangeCount = 1,
+        .pPushConstantRanges    = &pushRange
+    });
+
+    vk::ComputePipelineCreateInfo pipelineInfo {
+        .stage = {
+            .stage  = vk::ShaderStageFlagBits::eCompute,
+            .module = *shaderModule,
+            .pName  = "stepMain"
+        },
+        .layout = *pipelineLayout
+    };
+
+    pipeline = vk::raii::Pipeline(*ld, nullptr, pipelineInfo);
+}
+
+void Compute::step(float dt) {
+    struct PushConstants { float dt; uint32_t count; };
+    const PushConstants pc { dt, static_cast<uint32_t>(count) };
+
+    // the last step and publish are complete on the host, the barrier makes their writes visible to this step
+    const vk::MemoryBarrier2 before {
+        .srcStageMask  = vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eCopy,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask  = vk::PipelineStageFlagBits2::eComputeShader,
+        .dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead | vk::AccessFlagBits2::eShaderStorageWrite
+    };
+
+    const auto& cmd = commandBuffers[0];
+    cmd.reset();
+    cmd.begin(vk::CommandBufferBeginInfo { .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+    cmd.pipelineBarrier2(vk::DependencyInfo { .memoryBarrierCount = 1, .pMemoryBarriers = &before });
+    cmd.bindPipeline(vk::PipelineBindPoint::eCompute, *pipeline);
+    cmd.pushConstants<PushConstants>(*pipelineLayout, vk::ShaderStageFlagBits::eCompute, 0, pc);
+    cmd.bindDescriptorSets(vk::PipelineBindPoint::eCompute, *pipelineLayout, 0, { *descriptorSets[state] }, {});
+    cmd.dispatch((count + TILE - 1) / TILE, 1, 1);
+    cmd.end();
+
+    submit(cmd);
+    state ^= 1;
+}
+
+void Compute::publish(uint32_t slot) {
+    const vk::DeviceSize size = count * sizeof(float);
+
+    // draws of the slot finished before the caller got it back, only the step's writes need to be made visible
+    const vk::MemoryBarrier2 before {
+        .srcStageMask  = vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eVertexShader,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite,
+        .dstStageMask  = vk::PipelineStageFlagBits2::eCopy,
+        .dstAccessMask = vk::AccessFlagBits2::eTransferRead | vk::AccessFlagBits2::eTransferWrite
+    };
+
+    const vk::MemoryBarrier2 after {
+        .srcStageMask  = vk::PipelineStageFlagBits2::eCopy,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask  = vk::PipelineStageFlagBits2::eVertexShader,
+        .dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead
+    };
+
+    const auto& cmd = commandBuffers[0];
+    cmd.reset();
+    cmd.begin(vk::CommandBufferBeginInfo { .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+    cmd.pipelineBarrier2(vk::DependencyInfo { .memoryBarrierCount = 1, .pMemoryBarriers = &before });
+    cmd.copyBuffer(*xBuf[state], *xBuf[2 + slot], vk::BufferCopy { .srcOffset = 0, .dstOffset = 0, .size = size });
+    cmd.copyBuffer(*yBuf[state], *yBuf[2 + slot], vk::BufferCopy { .srcOffset = 0, .dstOffset = 0, .size = size });
+    cmd.pipelineBarrier2(vk::DependencyInfo { .memoryBarrierCount = 1, .pMemoryBarriers = &after });
+    cmd.end();
+
+    submit(cmd);
+}
+
+void Compute::download(const PhysicalDevice& pd, float* px, float* py) {
+    const vk::DeviceSize size = count * sizeof(float);
+
+    vk::raii::Buffer       staging = nullptr;
+    vk::raii::DeviceMemory stagingMem = nullptr;
+    createBuffer(*ld, pd, 2 * size, vk::BufferUsageFlagBits::eTransferDst,
+        vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent, staging, stagingMem);
+
+    const vk::MemoryBarrier2 before {
+        .srcStageMask  = vk::PipelineStageFlagBits2::eComputeShader | vk::PipelineStageFlagBits2::eCopy,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderStorageWrite | vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask  = vk::PipelineStageFlagBits2::eCopy,
+        .dstAccessMask = vk::AccessFlagBits2::eTransferRead
+    };
+
+    const vk::MemoryBarrier2 after {
+        .srcStageMask  = vk::PipelineStageFlagBits2::eCopy,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask  = vk::PipelineStageFlagBits2::eHost,
+        .dstAccessMask = vk::AccessFlagBits2::eHostRead
+    };
+
+    const auto& cmd = commandBuffers[0];
+    cmd.reset();
+    cmd.begin(vk::CommandBufferBeginInfo { .flags = vk::CommandBufferUsageFlagBits::eOneTimeSubmit });
+    cmd.pipelineBarrier2(vk::DependencyInfo { .memoryBarrierCount = 1, .pMemoryBarriers = &before });
+    cmd.copyBuffer(*xBuf[state], *staging, vk::BufferCopy { .srcOffset = 0, .dstOffset = 0, .size = size });
+    cmd.copyBuffer(*yBuf[state], *staging, vk::BufferCopy { .srcOffset = 0, .dstOffset = size, .size = size });
+    cmd.pipelineBarrier2(vk::DependencyInfo { .memoryBarrierCount = 1, .pMemoryBarriers = &after });
+    cmd.end();
+
+    submit(cmd);
+
+    const auto* mapped = static_cast<const uint8_t*>(stagingMem.mapMemory(0, 2 * size));
+    memcpy(px, mapped, size);
+    memcpy(py, mapped + size, size);
+    stagingMem.unmapMemory();
+}
+
+void Compute::submit(const vk::raii::CommandBuffer& cmd) {
+    ld->Device().resetFences(*fence);
+    {
+        // the renderer submits and presents on the same queue from its own thread
+        std::lock_guard<std::mutex> lock(ld->QueueLock());
+        ld->Queue().submit(vk::SubmitInfo { .commandBufferCount = 1, .pCommandBuffers = &*cmd }, *fence);
+    }
+
+    if (ld->Device().waitForFences(*fence, vk::True, UINT64_MAX) != vk::Result::eSuccess) {
+        throw std::runtime_error("failed to wait for fence");
+    }
+}
+
+uint32_t Compute::findMemType(const PhysicalDevice& pd, uint32_t f, vk::MemoryPropertyFlags p) {
+    auto memP = pd.Device().getMemoryProperties();
+    
+    for (uint32_t i = 0; i < memP.memoryTypeCount; i++) {
+        if ((f & (1 << i)) && (memP.memoryTypes[i].propertyFlags & p) == p) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find a suitable memory type");
+}
+
+void Compute::createBuffer(const LogicalDevice& ld, const PhysicalDevice& pd, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::raii::Buffer& buffer, vk::raii::DeviceMemory& bufferMemory) {
+    vk::BufferCreateInfo bufferInfo {
+        .size = size,
+        .usage = usage,
+        .sharingMode = vk::SharingMode::eExclusive,
+    };
+
+    buffer = vk::raii::Buffer(ld, bufferInfo);
+    
+    auto memRequirements = buffer.getMemoryRequirements();
+    vk::MemoryAllocateInfo allocInfo {
+        .allocationSize = memRequirements.size,
+        .memoryTypeIndex = findMemType(pd, memRequirements.memoryTypeBits, properties)
+    };
+
+    bufferMemory = vk::raii::DeviceMemory(ld, allocInfo);
+    buffer.bindMemory(*bufferMemory, 0);
+}
@@ -0,0 +1,69 @@
+#pragma once
+#include "../../definitions/graphics.hpp" // IWYU pragma: keep
+
+#include "../../data/data.hpp"
+#include "../PhysicalDevice/PhysicalDevice.hpp"
+#include "../LogicalDevice/LogicalDevice.hpp"
+#include "../MassBuffer/MassBuffer.hpp"
+
+/// @brief All pairs gravity as a compute shader. Positions and velocities live in device local buffers, steps
+/// ping pong between two position buffers and are submitted from the simulation thread on their own command
+/// buffer, so the step rate is independent of presentation. Finished steps are copied into device local render
+/// slots the renderer draws from, the host only ever sees the initial upload
+struct Compute {
+    public:
+    static constexpr uint32_t SLOTS = 3;
+
+    private:
+    static constexpr uint32_t TILE = 256;
+
+    const LogicalDevice* ld = nullptr;
+    size_t   count = 0;
+    uint32_t state = 0;     // position buffer holding the latest step
+
+    // positions per ping pong state and render slot, velocities are only ever read and written in place
+    vk::raii::Buffer       xBuf[2 + SLOTS] = { nullptr, nullptr, nullptr, nullptr, nullptr };
+    vk::raii::Buffer       yBuf[2 + SLOTS] = { nullptr, nullptr, nullptr, nullptr, nullptr };
+    vk::raii::DeviceMemory xMem[2 + SLOTS] = { nullptr, nullptr, nullptr, nullptr, nullptr };
+    vk::raii::DeviceMemory yMem[2 + SLOTS] = { nullptr, nullptr, nullptr, nullptr, nullptr };
+    vk::raii::Buffer       vxBuf = nullptr, vyBuf = nullptr;
+    vk::raii::DeviceMemory vxMem = nullptr, vyMem = nullptr;
+
+    vk::raii::DescriptorPool      descriptorPool      = nullptr;
+    vk::raii::DescriptorSetLayout descriptorSetLayout = nullptr;
+    vk::raii::DescriptorSets      descriptorSets      = nullptr;
+    vk::raii::PipelineLayout      pipelineLayout      = nullptr;
+    vk::raii::Pipeline            pipeline            = nullptr;
+
+    // owned by the simulation thread, the renderer records into its own pool
+    vk::raii::CommandPool    commandPool = nullptr;
+    vk::raii::CommandBuffers commandBuffers = nullptr;
+    vk::raii::Fence          fence = nullptr;
+
+    static const unsigned char shader_bytes[];
+    static const size_t shader_size;
+
+    static uint32_t findMemType(const PhysicalDevice& pd, uint32_t f, vk::MemoryPropertyFlags p);
+    static void createBuffer(const LogicalDevice& ld, const PhysicalDevice& pd, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::raii::Buffer& buffer, vk::raii::DeviceMemory& bufferMemory);
+
+    void init_upload(const data& d, const PhysicalDevice& pd, const MassBuffer& masses);
+    void init_descriptors(const MassBuffer& masses);
+    void init_pipeline();
+    void submit(const vk::raii::CommandBuffer& cmd);
+
+    public:
+    /// @brief Creates the device buffers and uploads positions, velocities and masses through a staging buffer
+    void init(const data& d, const LogicalDevice& ld, const PhysicalDevice& pd, const MassBuffer& masses);
+
+    /// @brief Runs one step of dt and waits for it, called from the simulation thread
+    void step(float dt);
+
+    /// @brief Copies the latest positions into a render slot and waits for the copy, the caller must own the slot
+    void publish(uint32_t slot);
+
+    /// @brief Reads the latest positions back to the host through a staging buffer, for checking against the cpu
+    void download(const PhysicalDevice& pd, float* px, float* py);
+
+    vk::DescriptorBufferInfo xInfo(uint32_t slot) const { return { *xBuf[2 + slot], 0, count * sizeof(float) }; }
+    vk::DescriptorBufferInfo yInfo(uint32_t slot) const { return { *yBuf[2 + slot], 0, count * sizeof(float) }; }
+};
@@ -5,22 +5,17 @@ void FrameData::init(const data& d, const LogicalDevice& ld, const PhysicalDevic
     vk::DeviceSize size = d.bodies() * sizeof(float);
 
     constexpr const vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eStorageBuffer;
+    constexpr const vk::BufferUsageFlags staging = vk::BufferUsageFlagBits::eTransferSrc;
     constexpr const vk::MemoryPropertyFlags properties = vk::MemoryPropertyFlagBits::eHostVisible | vk::MemoryPropertyFlagBits::eHostCoherent;
 
     createBuffer(ld, pd, size, usage, properties, xBuf, xMem);
     createBuffer(ld, pd, size, usage, properties, yBuf, yMem);
-    createBuffer(ld, pd, size, usage, properties, rBuf, rMem);
+    createBuffer(ld, pd, size, staging, properties, mBuf, mMem);
 
+    // mapped for the lifetime of the renderer, the simulation thread writes through these
     x = static_cast<float*>(xMem.mapMemory(0, size));
     y = static_cast<float*>(yMem.mapMemory(0, size));
-    r = static_cast<float*>(rMem.mapMemory(0, size));
-}
-
-void FrameData::update(const data& d) {
-    const size_t bytes = d.bodies() * sizeof(float);
-    memcpy(x, d.posx(), bytes);
-    memcpy(y, d.posy(), bytes);
-    memcpy(r, d.mass(), bytes);
+    m = static_cast<float*>(mMem.mapMemory(0, size));
 }
 
 vk::DescriptorBufferInfo FrameData::xInfo() const {
@@ -31,10 +26,6 @@ vk::DescriptorBufferInfo FrameData::yInfo() const {
     return { *yBuf, 0, count * sizeof(float)};
 }
 
-vk::DescriptorBufferInfo FrameData::rInfo() const {
-    return { *rBuf, 0, count * sizeof(float)};
-}
-
 uint32_t FrameData::findMemType(const PhysicalDevice& pd, uint32_t f, vk::MemoryPropertyFlags p) {
     auto memP = pd.Device().getMemoryProperties();
     
@@ -5,21 +5,26 @@
 #include "../PhysicalDevice/PhysicalDevice.hpp"
 #include "../LogicalDevice/LogicalDevice.hpp"
 
+/// @brief One published frame, positions are read by the shader straight from persistently mapped memory
+/// and masses are only staged here until they are copied into the device local MassBuffer
 struct FrameData {
     private:
     size_t count;
-    vk::raii::Buffer       xBuf = nullptr, yBuf = nullptr, rBuf = nullptr;
-    vk::raii::DeviceMemory xMem = nullptr, yMem = nullptr, rMem = nullptr;
-    float                  *x   = nullptr, *y   = nullptr, *r   = nullptr;
+    vk::raii::Buffer       xBuf = nullptr, yBuf = nullptr, mBuf = nullptr;
+    vk::raii::DeviceMemory xMem = nullptr, yMem = nullptr, mMem = nullptr;
+    float                  *x   = nullptr, *y   = nullptr, *m   = nullptr;
 
     static uint32_t findMemType(const PhysicalDevice& pd, uint32_t f, vk::MemoryPropertyFlags p);
     static void createBuffer(const LogicalDevice& ld, const PhysicalDevice& pd, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::raii::Buffer& buffer, vk::raii::DeviceMemory& bufferMemory);
 
     public:
     void init(const data& d, const LogicalDevice& ld, const PhysicalDevice& pd);
-    void update(const data& d);
+
+    inline float* X() const noexcept { return x; }
+    inline float* Y() const noexcept { return y; }
+    inline float* M() const noexcept { return m; }
+    inline const vk::raii::Buffer& MassStaging() const noexcept { return mBuf; }
 
     vk::DescriptorBufferInfo xInfo() const;
     vk::DescriptorBufferInfo yInfo() const;
-    vk::DescriptorBufferInfo rInfo() const;
 };
@@ -45,3 +45,43 @@ void LogicalDevice::init(const PhysicalDevice& pdevice, const vk::raii::SurfaceK
     device = vk::raii::Device(pd, deviceCreateInfo);
     queue = vk::raii::Queue(device, queueIdx, 0);
 }
+
+void LogicalDevice::init_compute(const PhysicalDevice& pdevice) {
+    const auto& pd = pdevice.Device();
+
+    auto queueFamilyProperties = pd.getQueueFamilyProperties();
+    bool found = false;
+    for (uint32_t qfpIndex = 0; qfpIndex < queueFamilyProperties.size(); qfpIndex++) {
+        if (queueFamilyProperties[qfpIndex].queueFlags & vk::QueueFlagBits::eCompute) {
+            queueIdx = qfpIndex;
+            found = true;
+            break;
+        }
+    }
+
+    if (!found) {
+        throw std::runtime_error("could not find a queue for compute");
+    }
+
+    // the compute solver only records synchronization2 barriers
+    vk::StructureChain<vk::PhysicalDeviceFeatures2, vk::PhysicalDeviceVulkan13Features> featureChain = {
+        {},
+        {.synchronization2 = true}
+    };
+
+    float queuePriority = 0.5f;
+    vk::DeviceQueueCreateInfo queueCreateInfo {
+        .queueFamilyIndex = queueIdx,
+        .queueCount       = 1,
+        .pQueuePriorities = &queuePriority
+    };
+
+    vk::DeviceCreateInfo deviceCreateInfo {
+        .pNext = &featureChain.get<vk::PhysicalDeviceFeatures2>(),
+        .queueCreateInfoCount = 1,
+        .pQueueCreateInfos = &queueCreateInfo
+    };
+
+    device = vk::raii::Device(pd, deviceCreateInfo);
+    queue = vk::raii::Queue(device, queueIdx, 0);
+}
@@ -1,4 +1,5 @@
 #pragma once
+#include <mutex>
 #include "../../definitions/graphics.hpp" // IWYU pragma: keep
 #include "../PhysicalDevice/PhysicalDevice.hpp"
 
@@ -6,6 +7,9 @@ struct LogicalDevice {
     public:
     void init(const PhysicalDevice& pdevice, const vk::raii::SurfaceKHR& surface);
 
+    /// @brief Creates a device with one compute queue and no swapchain, runs the compute solver without a window
+    void init_compute(const PhysicalDevice& pdevice);
+
     inline auto& Device() noexcept { return device; }
     inline auto& Queue() noexcept { return queue; }
 
@@ -13,6 +17,9 @@ struct LogicalDevice {
     inline const auto& Queue() const noexcept { return queue; }
     inline uint32_t QueueIdx() const noexcept { return queueIdx; }
 
+    /// @brief held around every submit, present and wait idle, the compute solver submits from the simulation thread
+    inline std::mutex& QueueLock() const noexcept { return queueLock; }
+
     inline operator vk::raii::Device&() { return device; }
     inline operator const vk::raii::Device&() const { return device; }
 
@@ -20,6 +27,7 @@ struct LogicalDevice {
     vk::raii::Device device    = nullptr;
     vk::raii::Queue  queue     = nullptr;
     uint32_t         queueIdx  = 0;
+    mutable std::mutex queueLock;
 
     static constexpr const char* deviceExtensions[1] = {
         vk::KHRSwapchainExtensionName
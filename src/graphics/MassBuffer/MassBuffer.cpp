@@ -0,0 +1,83 @@
+#include "MassBuffer.hpp"
+
+void MassBuffer::init(size_t n, const LogicalDevice& ld, const PhysicalDevice& pd) {
+    count = n;
+    vk::DeviceSize size = n * sizeof(float);
+
+    constexpr const vk::BufferUsageFlags usage = vk::BufferUsageFlagBits::eStorageBuffer | vk::BufferUsageFlagBits::eTransferDst;
+    constexpr const vk::MemoryPropertyFlags properties = vk::MemoryPropertyFlagBits::eDeviceLocal;
+
+    createBuffer(ld, pd, size, usage, properties, buffer, memory);
+}
+
+void MassBuffer::record_upload(const vk::raii::CommandBuffer& cmd, const vk::raii::Buffer& staging) const {
+    const vk::DeviceSize size = count * sizeof(float);
+
+    // draws and steps earlier in submission order may still be reading the old masses
+    vk::BufferMemoryBarrier2 before {
+        .srcStageMask = vk::PipelineStageFlagBits2::eVertexShader | vk::PipelineStageFlagBits2::eComputeShader,
+        .srcAccessMask = vk::AccessFlagBits2::eShaderStorageRead,
+        .dstStageMask = vk::PipelineStageFlagBits2::eCopy,
+        .dstAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = *buffer,
+        .offset = 0,
+        .size = size
+    };
+
+    cmd.pipelineBarrier2(vk::DependencyInfo {
+        .bufferMemoryBarrierCount = 1,
+        .pBufferMemoryBarriers = &before
+    });
+
+    cmd.copyBuffer(*staging, *buffer, vk::BufferCopy { .srcOffset = 0, .dstOffset = 0, .size = size });
+
+    vk::BufferMemoryBarrier2 after {
+        .srcStageMask = vk::PipelineStageFlagBits2::eCopy,
+        .srcAccessMask = vk::AccessFlagBits2::eTransferWrite,
+        .dstStageMask = vk::PipelineStageFlagBits2::eVertexShader | vk::PipelineStageFlagBits2::eComputeShader,
+        .dstAccessMask = vk::AccessFlagBits2::eShaderStorageRead,
+        .srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED,
+        .buffer = *buffer,
+        .offset = 0,
+        .size = size
+    };
+
+    cmd.pipelineBarrier2(vk::DependencyInfo {
+        .bufferMemoryBarrierCount = 1,
+        .pBufferMemoryBarriers = &after
+    });
+}
+
+uint32_t MassBuffer::findMemType(const PhysicalDevice& pd, uint32_t f, vk::MemoryPropertyFlags p) {
+    auto memP = pd.Device().getMemoryProperties();
+    
+    for (uint32_t i = 0; i < memP.memoryTypeCount; i++) {
+        if ((f & (1 << i)) && (memP.memoryTypes[i].propertyFlags & p) == p) {
+            return i;
+        }
+    }
+
+    throw std::runtime_error("failed to find a suitable memory type");
+}
+
+void MassBuffer::createBuffer(const LogicalDevice& ld, const PhysicalDevice& pd, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::raii::Buffer& buffer, vk::raii::DeviceMemory& bufferMemory) {
+    vk::BufferCreateInfo bufferInfo {
+        .size = size,
+        .usage = usage,
+        .sharingMode = vk::SharingMode::eExclusive,
+    };
+
+    buffer = vk::raii::Buffer(ld, bufferInfo);
+    
+    auto memRequirements = buffer.getMemoryRequirements();
+    vk::MemoryAllocateInfo allocInfo {
+        .allocationSize = memRequirements.size,
+        .memoryTypeIndex = findMemType(pd, memRequirements.memoryTypeBits, properties)
+    };
+
+    bufferMemory = vk::raii::DeviceMemory(ld, allocInfo);
+    buffer.bindMemory(*bufferMemory, 0);
+}
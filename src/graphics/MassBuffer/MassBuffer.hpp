@@ -0,0 +1,23 @@
+#pragma once
+#include "../../definitions/graphics.hpp" // IWYU pragma: keep
+#include "../PhysicalDevice/PhysicalDevice.hpp"
+#include "../LogicalDevice/LogicalDevice.hpp"
+
+/// @brief Device local masses, only rewritten when the body order changes
+struct MassBuffer {
+    private:
+    size_t count;
+    vk::raii::Buffer       buffer = nullptr;
+    vk::raii::DeviceMemory memory = nullptr;
+
+    static uint32_t findMemType(const PhysicalDevice& pd, uint32_t f, vk::MemoryPropertyFlags p);
+    static void createBuffer(const LogicalDevice& ld, const PhysicalDevice& pd, vk::DeviceSize size, vk::BufferUsageFlags usage, vk::MemoryPropertyFlags properties, vk::raii::Buffer& buffer, vk::raii::DeviceMemory& bufferMemory);
+
+    public:
+    void init(size_t n, const LogicalDevice& ld, const PhysicalDevice& pd);
+
+    /// @brief Records a copy from staging, barriers order it after earlier draws and before later ones
+    void record_upload(const vk::raii::CommandBuffer& cmd, const vk::raii::Buffer& staging) const;
+
+    vk::DescriptorBufferInfo Info() const { return { *buffer, 0, count * sizeof(float) }; }
+};
@@ -41,7 +41,10 @@ void Swapchain::recreate(const PhysicalDevice& pdevice, const LogicalDevice& lde
         glfwWaitEvents();
     }
 
-    ld.waitIdle();
+    {
+        std::lock_guard<std::mutex> lock(ldevice.QueueLock());
+        ld.waitIdle();
+    }
     init(pdevice, ldevice, surface, window);
 }
 
@@ -0,0 +1,111 @@
+#include "integrator.hpp"
+#include <cmath>
+
+#include "../simd/simd.hpp"
+
+/// @brief Updates velocities from the first acceleration row, v += a * dt
+void integrator::kick(data& d, const float dt) noexcept {
+    simd::active().kick(d.velx(), d.vely(), d.accx().row(0), d.accy().row(0), dt, d.bodies());
+}
+
+/// @brief Updates positions from velocities, x += v * dt
+void integrator::drift(data& d, const float dt) noexcept {
+    if (d.precise()) { drift_precise(d, dt); return; }
+    simd::active().drift(d.posx(), d.posy(), d.velx(), d.vely(), dt, d.bodies());
+}
+
+/// @brief Semi implicit euler update in a single pass, v += a * dt then x += v * dt
+void integrator::kick_drift(data& d, const float dt) noexcept {
+    if (d.precise()) { kick(d, dt); drift_precise(d, dt); return; }
+    simd::active().kick_drift(d.posx(), d.posy(), d.velx(), d.vely(), d.accx().row(0), d.accy().row(0), dt, d.bodies());
+}
+
+/// @brief Drift for precise data, positions are summed in double and split back into a float and its rounding error
+void integrator::drift_precise(data& d, const float dt) noexcept {
+    // aliasing
+    const size_t n = d.bodies();
+    float* __restrict px = d.posx();
+    float* __restrict py = d.posy();
+    float* __restrict pxl = d.posxl();
+    float* __restrict pyl = d.posyl();
+    const float* __restrict vx = d.velx();
+    const float* __restrict vy = d.vely();
+
+    #pragma omp parallel for simd schedule(static)
+    for (size_t i = 0; i < n; i++) {
+        const double x = (double)px[i] + pxl[i] + (double)vx[i] * dt;
+        const double y = (double)py[i] + pyl[i] + (double)vy[i] * dt;
+        px[i] = (float)x;
+        py[i] = (float)y;
+        pxl[i] = (float)(x - px[i]);
+        pyl[i] = (float)(y - py[i]);
+    }
+}
+
+/// @brief Half kick of the block scheme for the first count bodies of the level sorted list, which are the ones
+/// starting or finishing a step
+void integrator::kick_active(data& d, const float ft, size_t count) noexcept {
+    // aliasing
+    const uint32_t* __restrict idx = active_.data();
+    const uint8_t* __restrict lv = level_.data();
+    float* __restrict vx = d.velx();
+    float* __restrict vy = d.vely();
+    const float* ax = d.accx().row(0);
+    const float* ay = d.accy().row(0);
+
+    #pragma omp parallel for schedule(static)
+    for (size_t k = 0; k < count; k++) {
+        const uint32_t i = idx[k];
+        const float h = 0.5f * ft / float(size_t(1) << lv[i]);
+        vx[i] += ax[i] * h;
+        vy[i] += ay[i] * h;
+    }
+}
+
+/// @brief Assigns new levels to the bodies in the active list from dt = sqrt(2 * eta / |a|), bodies
+/// may always move to a finer level but only to a coarser one when it is synchronised at substep s.
+/// New levels stay synchronised at s, so sorting the active prefix by level keeps the whole list sorted
+void integrator::relevel(data& d, const float ft, size_t count, size_t s) noexcept {
+    // aliasing
+    const uint32_t* idx = active_.data();
+    uint8_t* __restrict lv = level_.data();
+    const float* ax = d.accx().row(0);
+    const float* ay = d.accy().row(0);
+
+    #pragma omp parallel for schedule(static)
+    for (size_t k = 0; k < count; k++) {
+        const uint32_t i = idx[k];
+        const float a = std::sqrt(ax[i]*ax[i] + ay[i]*ay[i]);
+        const float dt = std::sqrt(2.0f * eta_ / (a + 1e-30f));
+
+        int want = (int)std::ceil(std::log2(ft / dt));
+        want = std::clamp<int>(want, 0, levels_-1);
+
+        // coarsen one level at a time and only when the coarser level is synchronised
+        int lvl = lv[i];
+        if (want > lvl) {
+            lvl = want;
+        } else if (want < lvl && s % period(lvl-1) == 0) {
+            lvl = lvl-1;
+        }
+        lv[i] = lvl;
+    }
+
+    // counting sort of the active prefix from the finest level, levels coarser than k0 lie past it and keep
+    // their counts
+    const size_t k0 = synced(s);
+    size_t offset[17] = {};
+    for (size_t j = 0; j < count; j++) { offset[lv[idx[j]]]++; }
+
+    size_t total = 0;
+    for (size_t k = levels_; k-- > k0;) {
+        const size_t c = offset[k];
+        offset[k] = total;
+        total += c;
+        above_[k] = total;
+    }
+
+    uint32_t* __restrict out = scratch_.data();
+    for (size_t j = 0; j < count; j++) { out[offset[lv[idx[j]]]++] = idx[j]; }
+    std::copy(out, out + count, active_.data());
+}
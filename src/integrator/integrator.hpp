@@ -0,0 +1,171 @@
+#pragma once
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../data/data.hpp"
+
+/// @brief Time integration schemes shared by every solver, the force callback must leave the
+/// accelerations of the current positions in the first row of accx and accy
+struct integrator {
+    public:
+    enum scheme { EULER, LEAPFROG, YOSHIDA, BLOCK };
+
+    // default constructor
+    integrator() : scheme_(EULER), primed_(false), forces_(0), levels_(1), eta_(0.0f) {}
+
+    // custom constructor, levels and eta are only used by the block scheme
+    integrator(const std::string& name, size_t levels, float eta) :
+        primed_(false),
+        forces_(0),
+        levels_(std::clamp<size_t>(levels, 1, 16)),
+        eta_(eta) {
+            if (name == "euler") {
+                scheme_ = EULER;
+            } else if (name == "leapfrog") {
+                scheme_ = LEAPFROG;
+            } else if (name == "yoshida") {
+                scheme_ = YOSHIDA;
+            } else if (name == "block") {
+                scheme_ = BLOCK;
+            } else {
+                throw std::runtime_error("invalid integrator");
+            }
+        }
+
+    constexpr scheme type() const noexcept { return scheme_; }
+
+    /// @brief number of body force evaluations made during the last step
+    constexpr size_t forces() const noexcept { return forces_; }
+
+    /// @brief Advances the simulation by ft, the block scheme is stepped through step_block instead
+    /// @param d Simulation data
+    /// @param ft Fixed time used for update
+    /// @param force Callable computing accelerations for the current positions
+    template<typename F>
+    void step(data& d, const float ft, F&& force) noexcept {
+        forces_ = 0;
+
+        switch (scheme_) {
+            case EULER:
+                // semi implicit euler
+                force();
+                kick_drift(d, ft);
+                forces_ = d.bodies();
+                break;
+            case LEAPFROG:
+                // kick drift kick, the closing accelerations are reused to open the next step
+                if (!primed_) { force(); primed_ = true; forces_ += d.bodies(); }
+                kick(d, 0.5f * ft);
+                drift(d, ft);
+                force();
+                kick(d, 0.5f * ft);
+                forces_ += d.bodies();
+                break;
+            case YOSHIDA:
+                // fourth order composition of drift kick drift leapfrog steps
+                drift(d, c1 * ft);
+                force();
+                kick(d, d1 * ft);
+                drift(d, c2 * ft);
+                force();
+                kick(d, d2 * ft);
+                drift(d, c2 * ft);
+                force();
+                kick(d, d1 * ft);
+                drift(d, c1 * ft);
+                forces_ = 3 * d.bodies();
+                break;
+            case BLOCK:
+                break;
+        }
+    }
+
+    /// @brief Advances the simulation by ft with hierarchical block timesteps, body i steps with
+    /// ft / 2^level[i] as kick drift kick leapfrog and forces are only computed for bodies finishing a
+    /// step, bodies must not be reordered between calls as levels and accelerations are kept by index.
+    /// Bodies are kept sorted by level so the ones synchronised on a substep are a prefix of the list,
+    /// kicks, forces and relevelling cost O(active) per substep. Every substep still drifts all n bodies
+    /// as they are the sources of the force sum, which is O(n 2^(levels-1)) per step against O(active n)
+    /// for the forces
+    /// @param d Simulation data
+    /// @param ft Fixed time used for update, the largest step any body takes
+    /// @param force Callable taking a list of body indices and count, computing their accelerations
+    template<typename F>
+    void step_block(data& d, const float ft, F&& force) noexcept {
+        const size_t n = d.bodies();
+        const size_t sub = size_t(1) << (levels_-1);
+        const float dtmin = ft / sub;
+        forces_ = 0;
+
+        if (!primed_ || level_.size() != n) {
+            level_.assign(n, 0);
+            active_.resize(n);
+            scratch_.resize(n);
+            above_.assign(levels_+1, 0);
+            for (size_t i = 0; i < n; i++) { active_[i] = i; }
+
+            force(active_.data(), n);
+            relevel(d, ft, n, 0);
+            forces_ += n;
+            primed_ = true;
+        }
+
+        for (size_t s = 0; s < sub; s++) {
+            // opening half kick for bodies starting a step
+            kick_active(d, ft, above_[synced(s)]);
+            drift(d, dtmin);
+
+            // bodies finishing their step at the end of this substep
+            const size_t count = above_[synced(s+1)];
+
+            force(active_.data(), count);
+            kick_active(d, ft, count);
+            relevel(d, ft, count, s+1);
+            forces_ += count;
+        }
+    }
+
+    static void kick(data& d, const float dt) noexcept;
+    static void drift(data& d, const float dt) noexcept;
+    static void kick_drift(data& d, const float dt) noexcept;
+    static void drift_precise(data& d, const float dt) noexcept;
+
+    private:
+    scheme scheme_;
+    bool primed_;
+    size_t forces_;
+
+    // block scheme state, body levels and every body sorted from the finest level to the coarsest,
+    // the bodies on level k or finer are the first above_[k] of active_
+    size_t levels_;
+    float eta_;
+    std::vector<uint8_t> level_;
+    std::vector<uint32_t> active_;
+    std::vector<uint32_t> scratch_;
+    std::vector<size_t> above_;
+
+    /// @brief substeps of the finest level a body on level k spans
+    inline size_t period(uint8_t k) const noexcept { return size_t(1) << (levels_-1-k); }
+
+    /// @brief coarsest level with a step starting or ending at substep s, every finer level is synchronised too
+    inline size_t synced(size_t s) const noexcept {
+        if (s == 0) { return 0; }
+        const size_t z = std::countr_zero(s);
+        return z >= levels_-1 ? 0 : levels_-1-z;
+    }
+
+    void kick_active(data& d, const float ft, size_t count) noexcept;
+    void relevel(data& d, const float ft, size_t count, size_t s) noexcept;
+
+    // yoshida coefficients, w1 = 1 / (2 - 2^(1/3)) and w0 = -2^(1/3) / (2 - 2^(1/3))
+    static constexpr float w1 = 1.35120719195965763f;
+    static constexpr float w0 = -1.70241438391931527f;
+    static constexpr float c1 = 0.5f * w1;
+    static constexpr float c2 = 0.5f * (w0 + w1);
+    static constexpr float d1 = w1;
+    static constexpr float d2 = w0;
+};
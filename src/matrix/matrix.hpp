@@ -1,4 +1,5 @@
-#pragma onces
+#pragma once
+#include <algorithm>
 #include <cstddef>
 #include <malloc.h>
 #include <cstring>
@@ -93,6 +94,28 @@ struct matrix {
         std::memset(data_, 0, bytes);
     }
 
+    /// @brief Sums every row into the first, each thread reduces its own block of columns across all
+    /// rows in a single parallel region. The block of the first row is added into once per row, it is
+    /// small enough to stay in L1 meanwhile so only the other rows stream from memory
+    void sum_rows() noexcept {
+        constexpr size_t block = 1024;
+        float* __restrict top = data_;
+
+        #pragma omp parallel for schedule(static)
+        for (size_t c = 0; c < cols_; c += block) {
+            const size_t e = std::min(c + block, cols_);
+
+            for (size_t r = 1; r < rows_; r++) {
+                const float* __restrict src = &data_[r*stride_];
+
+                #pragma omp simd
+                for (size_t k = c; k < e; k++) {
+                    top[k] += src[k];
+                }
+            }
+        }
+    }
+
     const float& operator () (size_t r, size_t c) const noexcept {
         return data_[r*stride_+c];
     }
@@ -105,6 +128,7 @@ struct matrix {
 
     constexpr size_t rows() const noexcept { return rows_; }
     constexpr size_t cols() const noexcept { return cols_; }
+    constexpr size_t stride() const noexcept { return stride_; }
 
     private:
     float* __restrict data_;
@@ -0,0 +1,85 @@
+#pragma once
+#include <cmath>
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <omp.h>
+#include <vector>
+
+/// @brief Iterative radix 2 Cooley-Tukey FFT over square power of two grids, twiddles and the bit reversal
+/// permutation are computed once per size. Inverse transforms are not normalized
+struct fft {
+    private:
+    size_t n_;
+    size_t log_;
+    std::vector<uint32_t> rev_;
+    std::vector<std::complex<float>> twiddle_;
+    std::vector<std::complex<float>> cols_;
+
+    public:
+    // default constructor
+    fft() : n_(0), log_(0) {}
+
+    // custom constructor, n must be a power of two
+    fft(size_t n) : n_(n), log_(__builtin_ctzll(n)), rev_(n), twiddle_(n/2) {
+        for (size_t i = 0; i < n; i++) {
+            uint32_t r = 0;
+            for (size_t b = 0; b < log_; b++) { r |= ((i >> b) & 1) << (log_ - 1 - b); }
+            rev_[i] = r;
+        }
+
+        // computed in double so large sizes keep full float precision
+        for (size_t k = 0; k < n/2; k++) {
+            const double a = -2.0 * M_PI * k / n;
+            twiddle_[k] = { (float)std::cos(a), (float)std::sin(a) };
+        }
+    }
+
+    constexpr inline size_t size() const noexcept { return n_; }
+
+    /// @brief Transforms n contiguous values in place
+    inline void transform(std::complex<float>* __restrict a, bool inverse) const noexcept {
+        for (size_t i = 0; i < n_; i++) {
+            if (i < rev_[i]) { std::swap(a[i], a[rev_[i]]); }
+        }
+
+        for (size_t len = 2; len <= n_; len <<= 1) {
+            const size_t half = len >> 1;
+            const size_t step = n_ / len;
+
+            for (size_t i = 0; i < n_; i += len) {
+                for (size_t k = 0; k < half; k++) {
+                    std::complex<float> w = twiddle_[k * step];
+                    if (inverse) { w = std::conj(w); }
+
+                    const std::complex<float> u = a[i + k];
+                    const std::complex<float> v = a[i + k + half] * w;
+                    a[i + k] = u + v;
+                    a[i + k + half] = u - v;
+                }
+            }
+        }
+    }
+
+    /// @brief Transforms an n by n row major grid in place, rows then columns, both spread across threads.
+    /// Columns are gathered into a per thread buffer so every transform runs over contiguous memory
+    inline void transform2d(std::complex<float>* __restrict grid, bool inverse) noexcept {
+        const size_t n = n_;
+        cols_.resize(omp_get_max_threads() * n);
+
+        #pragma omp parallel
+        {
+            std::complex<float>* __restrict col = &cols_[omp_get_thread_num() * n];
+
+            #pragma omp for schedule(static)
+            for (size_t r = 0; r < n; r++) { transform(&grid[r * n], inverse); }
+
+            #pragma omp for schedule(static)
+            for (size_t c = 0; c < n; c++) {
+                for (size_t r = 0; r < n; r++) { col[r] = grid[r * n + c]; }
+                transform(col, inverse);
+                for (size_t r = 0; r < n; r++) { grid[r * n + c] = col[r]; }
+            }
+        }
+    }
+};
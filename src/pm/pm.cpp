@@ -0,0 +1,245 @@
+/*
+Author: Joey Soroka
+Updated: 10/17/26
+Purpose: Implements the particle mesh solver
+Comments: Bodies attract with the 3D 1/r potential while confined to the plane, which is not the Green's function
+of the 2D Poisson equation, so the mesh convolves with the acceleration kernel itself. Both components share a
+single complex transform, the kernel holds kx + i ky and the inverse transform yields ax + i ay
+*/
+
+#include "pm.hpp"
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+#include "../simd/simd.hpp"
+
+pm::pm(size_t grid, bool p3m) :
+    n_(std::bit_ceil(std::max<size_t>(grid, 8))),
+    m_(2 * n_),
+    p3m_(p3m),
+    minx_(0.0f),
+    miny_(0.0f),
+    h_(1.0f) {}
+
+size_t pm::evaluate(const data& d, float* __restrict ax, float* __restrict ay) {
+    if (d.bodies() == 0) { return 0; }
+    if (kernel_.empty()) { build_kernel(); }
+
+    bounds(d);
+    deposit(d);
+    solve();
+    interpolate(d, ax, ay);
+
+    return p3m_ ? short_range(d, ax, ay) : 0;
+}
+
+double pm::short_factor(double r) noexcept {
+    const double s = r / (2.0 * split);
+    return std::erfc(s) + (r / (split * std::sqrt(M_PI))) * std::exp(-s*s);
+}
+
+/// @brief Transforms the kernel over every displacement between two cells of the unpadded grid, in cell units.
+/// Displacements wrap around the padded grid so the circular convolution equals the linear one over the bodies
+void pm::build_kernel() {
+    const int64_t n = n_;
+    const int64_t m = m_;
+
+    fft_ = fft(m_);
+    kernel_.assign(m_ * m_, { 0.0f, 0.0f });
+    field_.resize(m_ * m_);
+
+    // acceleration at p from unit mass at q, d = p - q
+    #pragma omp parallel for schedule(static)
+    for (int64_t j = -(n-1); j <= n-1; j++) {
+        for (int64_t i = -(n-1); i <= n-1; i++) {
+            if (i == 0 && j == 0) { continue; }
+
+            const double r = std::sqrt((double)(i*i + j*j));
+            double s = 1.0 / (r*r*r);
+            if (p3m_) { s *= 1.0 - short_factor(r); }
+
+            kernel_[((j + m) % m) * m_ + (i + m) % m] = { (float)(-i * s), (float)(-j * s) };
+        }
+    }
+
+    fft_.transform2d(kernel_.data(), false);
+
+    // squared distance samples in cells, one past the end so interpolation never reads out of bounds
+    const double rc = split * cutoff;
+    factor_.resize(table + 2);
+    for (size_t k = 0; k <= table; k++) { factor_[k] = short_factor(std::sqrt(rc*rc * k / table)); }
+    factor_[table+1] = factor_[table];
+}
+
+/// @brief Fits square cells over the bounding box, leaving the last row and column free for the cloud in cell spill
+void pm::bounds(const data& d) noexcept {
+    const size_t n = d.bodies();
+    const float* __restrict px = d.posx();
+    const float* __restrict py = d.posy();
+
+    float minx = std::numeric_limits<float>::max();
+    float miny = std::numeric_limits<float>::max();
+    float maxx = std::numeric_limits<float>::lowest();
+    float maxy = std::numeric_limits<float>::lowest();
+
+    #pragma omp parallel for simd schedule(static) reduction(min:minx, miny) reduction(max:maxx, maxy)
+    for (size_t i = 0; i < n; i++) {
+        minx = std::min(minx, px[i]);
+        miny = std::min(miny, py[i]);
+        maxx = std::max(maxx, px[i]);
+        maxy = std::max(maxy, py[i]);
+    }
+
+    const float range = std::max(maxx - minx, maxy - miny);
+    minx_ = minx;
+    miny_ = miny;
+    h_ = range > 0.0f ? range / (float)(n_ - 2) * 1.0001f : 1.0f;
+}
+
+/// @brief Cloud in cell assignment into per thread grids which are then summed into the padded field
+void pm::deposit(const data& d) noexcept {
+    const size_t n = d.bodies();
+    const size_t cells = n_ * n_;
+    const float* __restrict px = d.posx();
+    const float* __restrict py = d.posy();
+    const float* __restrict ma = d.mass();
+    const float inv = 1.0f / h_;
+
+    rho_.resize(omp_get_max_threads() * cells);
+    size_t threads = 1;
+
+    #pragma omp parallel
+    {
+        #pragma omp single
+        threads = omp_get_num_threads();
+
+        float* __restrict g = &rho_[omp_get_thread_num() * cells];
+        std::fill(g, g + cells, 0.0f);
+
+        #pragma omp for schedule(static)
+        for (size_t i = 0; i < n; i++) {
+            const float fx = (px[i] - minx_) * inv;
+            const float fy = (py[i] - miny_) * inv;
+            const size_t x = (size_t)fx;
+            const size_t y = (size_t)fy;
+            const float wx = fx - x;
+            const float wy = fy - y;
+
+            g[y*n_ + x]         += ma[i] * (1.0f-wx) * (1.0f-wy);
+            g[y*n_ + x+1]       += ma[i] * wx * (1.0f-wy);
+            g[(y+1)*n_ + x]     += ma[i] * (1.0f-wx) * wy;
+            g[(y+1)*n_ + x+1]   += ma[i] * wx * wy;
+        }
+    }
+
+    #pragma omp parallel for schedule(static)
+    for (size_t y = 0; y < m_; y++) {
+        for (size_t x = 0; x < m_; x++) {
+            float sum = 0.0f;
+            if (y < n_ && x < n_) {
+                for (size_t t = 0; t < threads; t++) { sum += rho_[t * cells + y*n_ + x]; }
+            }
+            field_[y*m_ + x] = { sum, 0.0f };
+        }
+    }
+}
+
+void pm::solve() noexcept {
+    const size_t cells = m_ * m_;
+
+    fft_.transform2d(field_.data(), false);
+
+    #pragma omp parallel for schedule(static)
+    for (size_t c = 0; c < cells; c++) { field_[c] *= kernel_[c]; }
+
+    fft_.transform2d(field_.data(), true);
+}
+
+/// @brief Cloud in cell interpolation of the field, also undoes the cell units of the kernel and the unnormalized inverse
+void pm::interpolate(const data& d, float* __restrict ax, float* __restrict ay) const noexcept {
+    const size_t n = d.bodies();
+    const float* __restrict px = d.posx();
+    const float* __restrict py = d.posy();
+    const float inv = 1.0f / h_;
+    const float scale = 1.0f / (h_ * h_ * (float)(m_ * m_));
+
+    #pragma omp parallel for schedule(static)
+    for (size_t i = 0; i < n; i++) {
+        const float fx = (px[i] - minx_) * inv;
+        const float fy = (py[i] - miny_) * inv;
+        const size_t x = (size_t)fx;
+        const size_t y = (size_t)fy;
+        const float wx = fx - x;
+        const float wy = fy - y;
+
+        const std::complex<float> a =
+            field_[y*m_ + x]         * ((1.0f-wx) * (1.0f-wy)) +
+            field_[y*m_ + x+1]       * (wx * (1.0f-wy)) +
+            field_[(y+1)*m_ + x]     * ((1.0f-wx) * wy) +
+            field_[(y+1)*m_ + x+1]   * (wx * wy);
+
+        ax[i] = a.real() * scale;
+        ay[i] = a.imag() * scale;
+    }
+}
+
+/// @brief Sums the part of the pair force the mesh leaves out for every pair closer than the cutoff. Bodies are
+/// sorted by cell in row major order, so the neighbours of a cell within one grid row are a contiguous range
+/// @return Number of pairs summed
+size_t pm::short_range(const data& d, float* __restrict ax, float* __restrict ay) noexcept {
+    const size_t n = d.bodies();
+    const size_t cells = n_ * n_;
+    const float* __restrict px = d.posx();
+    const float* __restrict py = d.posy();
+    const float* __restrict ma = d.mass();
+    const float ih = 1.0f / h_;
+
+    keys_.resize(n);
+    idxs_.resize(n);
+    start_.resize(cells + 1);
+    sx_.resize(n);
+    sy_.resize(n);
+    sm_.resize(n);
+
+    #pragma omp parallel for simd schedule(static)
+    for (size_t i = 0; i < n; i++) {
+        const size_t x = (size_t)((px[i] - minx_) * ih);
+        const size_t y = (size_t)((py[i] - miny_) * ih);
+        keys_[i] = y*n_ + x;
+        idxs_[i] = i;
+    }
+
+    sorter_.sort(keys_, idxs_);
+
+    #pragma omp parallel for schedule(static)
+    for (size_t c = 0; c <= cells; c++) {
+        start_[c] = std::lower_bound(keys_.begin(), keys_.end(), (uint64_t)c) - keys_.begin();
+    }
+
+    #pragma omp parallel for simd schedule(static)
+    for (size_t k = 0; k < n; k++) {
+        sx_[k] = px[idxs_[k]];
+        sy_[k] = py[idxs_[k]];
+        sm_[k] = ma[idxs_[k]];
+    }
+
+    // the pair loop is dispatched per isa, distances are compared in cells squared inside it
+    const float rc = split * cutoff * h_;
+    const simd::cell_args a {
+        sx_.data(), sy_.data(), sm_.data(), idxs_.data(), start_.data(), factor_.data(),
+        n_, (size_t)std::ceil(split * cutoff), table, rc * rc, ax, ay
+    };
+    const auto kernel = simd::active().short_range;
+
+    size_t interactions = 0;
+
+    #pragma omp parallel for schedule(dynamic, 64) reduction(+:interactions)
+    for (size_t c = 0; c < cells; c++) {
+        if (start_[c] == start_[c+1]) { continue; }
+        interactions += kernel(a, c);
+    }
+
+    return interactions;
+}
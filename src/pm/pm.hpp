@@ -0,0 +1,67 @@
+#pragma once
+#include <complex>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "fft.hpp"
+#include "../data/data.hpp"
+#include "../sort/radix.hpp"
+
+/// @brief Particle mesh solver. Mass is assigned to a square grid over the bounding box with cloud in cell
+/// weights, convolved with the acceleration kernel through zero padded FFTs (Hockney-Eastwood, so the
+/// boundaries are isolated rather than periodic) and interpolated back with the same weights.
+/// With p3m the mesh only carries the smooth long range part of an erf split and pairs closer than the
+/// cutoff are summed directly over a cell list
+struct pm {
+    public:
+    static constexpr float split = 1.25f;   // split scale in cells
+    static constexpr float cutoff = 4.5f;   // short range cutoff in units of split
+    static constexpr size_t table = 1024;   // short range factor samples over squared distance
+
+    // default constructor
+    pm() : pm(256, false) {}
+
+    // custom constructor, grid is rounded up to a power of two, the kernel is built on first use
+    pm(size_t grid, bool p3m);
+
+    /// @brief Computes the acceleration of every body, the order of bodies is left untouched
+    /// @param d Simulation data
+    /// @param ax Output accelerations along x
+    /// @param ay Output accelerations along y
+    /// @return Number of body pairs summed by the short range correction
+    size_t evaluate(const data& d, float* __restrict ax, float* __restrict ay);
+
+    constexpr size_t grid() const noexcept { return n_; }
+
+    private:
+    size_t n_;      // cells per side
+    size_t m_;      // padded cells per side
+    bool p3m_;
+
+    // grid geometry of the current evaluation, cells are h_ wide with cell (0, 0) at (minx_, miny_)
+    float minx_, miny_, h_;
+
+    fft fft_;
+    std::vector<std::complex<float>> kernel_;   // transform of kx + i ky over the padded grid
+    std::vector<std::complex<float>> field_;    // density, then ax + i ay after the inverse transform
+    std::vector<float> rho_;                    // per thread deposit grids
+
+    // short range cell list, bodies sorted by cell with per cell start offsets
+    std::vector<float> factor_;
+    std::vector<uint64_t> keys_;
+    std::vector<uint32_t> idxs_;
+    std::vector<uint32_t> start_;
+    std::vector<float> sx_, sy_, sm_;
+    radix sorter_;
+
+    void build_kernel();
+    void bounds(const data& d) noexcept;
+    void deposit(const data& d) noexcept;
+    void solve() noexcept;
+    void interpolate(const data& d, float* __restrict ax, float* __restrict ay) const noexcept;
+    size_t short_range(const data& d, float* __restrict ax, float* __restrict ay) noexcept;
+
+    /// @brief fraction of the pair force left to the short range sum at distance r in cells
+    static double short_factor(double r) noexcept;
+};
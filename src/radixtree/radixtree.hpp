@@ -0,0 +1,176 @@
+#pragma once
+#include <cstdint>
+#include <limits>
+
+#include "../data/data.hpp"
+#include "../reorder/reorder.hpp"
+
+/// @brief Binary radix tree (Karras 2012) built bottom up over bodies already sorted along a space filling curve.
+/// Internal nodes live in a flat SoA arena that is reused across frames, leaves are the bodies themselves
+/// and every node covers a contiguous range of bodies
+struct radixtree {
+    public:
+    static constexpr uint32_t leaf = 0x80000000u;   // marks a child index as a body rather than a node
+    static constexpr uint32_t none = 0xFFFFFFFFu;   // parent of the root
+    static constexpr size_t leaf_size = 16;         // nodes with at most this many bodies are summed directly
+    static constexpr size_t max_depth = 128;        // 64 key bits plus index bits used to split duplicates
+
+    // default constructor
+    radixtree() : nodes_(0), cap_(0) {}
+
+    inline void build(const data& data, const reorder& z) noexcept {
+        const size_t n = data.bodies();
+        nodes_ = n > 1 ? n-1 : 0;
+        if (nodes_ == 0) { return; }
+        reserve(n);
+
+        build_hierarchy(z, n);
+        build_nodes(data, n);
+    }
+
+    /// @brief Recomputes node mass, center of mass and bounds for the current positions, keeping the topology of the
+    /// last build. Bodies must not have been reordered since, nodes only grow looser as they drift
+    inline void refit(const data& data) noexcept {
+        if (nodes_ == 0) { return; }
+
+        #pragma omp parallel for simd schedule(static)
+        for (size_t i = 0; i < nodes_; i++) { flags_[i] = 0; }
+
+        build_nodes(data, data.bodies());
+    }
+
+    constexpr inline size_t size() const noexcept { return nodes_; }
+
+    const inline float* __restrict cx() const noexcept { return cx_.data(); }
+    const inline float* __restrict cy() const noexcept { return cy_.data(); }
+    const inline float* __restrict mass() const noexcept { return mass_.data(); }
+    const inline float* __restrict minx() const noexcept { return minx_.data(); }
+    const inline float* __restrict miny() const noexcept { return miny_.data(); }
+    const inline float* __restrict maxx() const noexcept { return maxx_.data(); }
+    const inline float* __restrict maxy() const noexcept { return maxy_.data(); }
+    const inline uint32_t* __restrict first() const noexcept { return first_.data(); }
+    const inline uint32_t* __restrict last() const noexcept { return last_.data(); }
+    const inline uint32_t* __restrict left() const noexcept { return left_.data(); }
+    const inline uint32_t* __restrict right() const noexcept { return right_.data(); }
+
+    /// @brief parent of every internal node, none for the root
+    const inline uint32_t* __restrict parent() const noexcept { return parent_.data(); }
+
+    private:
+    size_t nodes_;
+    size_t cap_;
+
+    // node data, body range is [first, last)
+    std::vector<float> cx_, cy_, mass_;
+    std::vector<float> minx_, miny_, maxx_, maxy_;
+    std::vector<uint32_t> first_, last_, left_, right_;
+
+    // build scratch, parents of internal nodes and of bodies, and per node arrival counters
+    std::vector<uint32_t> parent_, lparent_, flags_;
+
+    inline void reserve(size_t n) noexcept {
+        if (n <= cap_) { return; }
+        cap_ = n;
+
+        for (auto* v : { &cx_, &cy_, &mass_, &minx_, &miny_, &maxx_, &maxy_ }) { v->resize(n); }
+        for (auto* v : { &first_, &last_, &left_, &right_, &parent_, &lparent_, &flags_ }) { v->resize(n); }
+    }
+
+    /// @brief Computes the range and split of every internal node independently
+    inline void build_hierarchy(const reorder& z, size_t n) noexcept {
+        // length of the common prefix of keys i and j, duplicate keys fall back on their index
+        auto delta = [&](int64_t i, int64_t j) -> int {
+            if (j < 0 || j >= (int64_t)n) { return -1; }
+            const uint64_t a = z.code(i);
+            const uint64_t b = z.code(j);
+            if (a == b) { return 64 + __builtin_clzll((uint64_t)(i ^ j)); }
+            return __builtin_clzll(a ^ b);
+        };
+
+        parent_[0] = none;
+
+        #pragma omp parallel for schedule(static)
+        for (int64_t i = 0; i < (int64_t)n-1; i++) {
+            // direction of the range
+            const int64_t d = delta(i, i+1) - delta(i, i-1) > 0 ? 1 : -1;
+            const int dmin = delta(i, i-d);
+
+            // upper bound for the length of the range, then binary search the other end
+            int64_t lmax = 2;
+            while (delta(i, i + lmax*d) > dmin) { lmax *= 2; }
+
+            int64_t l = 0;
+            for (int64_t t = lmax/2; t >= 1; t /= 2) {
+                if (delta(i, i + (l+t)*d) > dmin) { l += t; }
+            }
+            const int64_t j = i + l*d;
+
+            // binary search the split position
+            const int dnode = delta(i, j);
+            int64_t s = 0;
+            int64_t t = l;
+            do {
+                t = (t+1) / 2;
+                if (delta(i, i + (s+t)*d) > dnode) { s += t; }
+            } while (t > 1);
+            const int64_t gamma = i + s*d + std::min<int64_t>(d, 0);
+
+            const int64_t lo = std::min(i, j);
+            const int64_t hi = std::max(i, j);
+
+            first_[i] = lo;
+            last_[i] = hi+1;
+            flags_[i] = 0;
+
+            if (lo == gamma) { left_[i] = gamma | leaf; lparent_[gamma] = i; }
+            else { left_[i] = gamma; parent_[gamma] = i; }
+
+            if (hi == gamma+1) { right_[i] = (gamma+1) | leaf; lparent_[gamma+1] = i; }
+            else { right_[i] = gamma+1; parent_[gamma+1] = i; }
+        }
+    }
+
+    /// @brief Computes mass, center of mass and bounds by climbing from every body towards the root,
+    /// the second thread to arrive at a node is the one that fills it in
+    inline void build_nodes(const data& data, size_t n) noexcept {
+        const float* __restrict px = data.posx();
+        const float* __restrict py = data.posy();
+        const float* __restrict ma = data.mass();
+
+        #pragma omp parallel for schedule(static)
+        for (size_t b = 0; b < n; b++) {
+            uint32_t p = lparent_[b];
+
+            while (p != none) {
+                if (__atomic_fetch_add(&flags_[p], 1, __ATOMIC_ACQ_REL) == 0) { break; }
+
+                float mass = 0.0f, mx = 0.0f, my = 0.0f;
+                float minx = std::numeric_limits<float>::max();
+                float miny = std::numeric_limits<float>::max();
+                float maxx = std::numeric_limits<float>::lowest();
+                float maxy = std::numeric_limits<float>::lowest();
+
+                for (const uint32_t c : { left_[p], right_[p] }) {
+                    if (c & leaf) {
+                        const uint32_t j = c & ~leaf;
+                        mass += ma[j]; mx += px[j]*ma[j]; my += py[j]*ma[j];
+                        minx = std::min(minx, px[j]); maxx = std::max(maxx, px[j]);
+                        miny = std::min(miny, py[j]); maxy = std::max(maxy, py[j]);
+                    } else {
+                        mass += mass_[c]; mx += cx_[c]*mass_[c]; my += cy_[c]*mass_[c];
+                        minx = std::min(minx, minx_[c]); maxx = std::max(maxx, maxx_[c]);
+                        miny = std::min(miny, miny_[c]); maxy = std::max(maxy, maxy_[c]);
+                    }
+                }
+
+                mass_[p] = mass;
+                cx_[p] = mass > 0.0f ? mx / mass : 0.5f * (minx + maxx);
+                cy_[p] = mass > 0.0f ? my / mass : 0.5f * (miny + maxy);
+                minx_[p] = minx; miny_[p] = miny;
+                maxx_[p] = maxx; maxy_[p] = maxy;
+
+                p = parent_[p];
+            }
+        }
+    }
+};
@@ -11,18 +11,41 @@
 #include "../graphics/CommandBuffer/CommandBuffer.hpp"
 #include "../graphics/FrameData/FrameData.hpp"
 #include "../graphics/UBOBuffer/UBOBuffer.hpp"
+#include "../graphics/MassBuffer/MassBuffer.hpp"
+#include "../graphics/Compute/Compute.hpp"
 
 #include "../camera/camera.hpp"
 #include "../data/data.hpp"
 
 struct renderer {
     public:
-    std::chrono::nanoseconds render(const data& data, float dt);
+    static constexpr int FRAME_SLOTS                = 3;
+
+    /// @brief A frame the simulation publishes into, positions point straight at mapped memory the shader reads,
+    /// masses are staged and only copied to the device when order differs from the last uploaded order
+    struct frame {
+        float*   posx;
+        float*   posy;
+        float*   mass;
+        uint64_t order;
+        uint32_t slot;
+    };
+
+    std::chrono::nanoseconds render(const frame& f, float dt);
     void cleanup();
 
-    void init(const data& data, const std::string& exePath);
+    void init(const data& data, const std::string& exePath, bool simulate);
     bool should_close() { return glfwWindowShouldClose(window); }
 
+    /// @brief compute solver publishing into the render slots, null unless initialized to simulate
+    Compute* gpu() noexcept { return simulate ? &compute : nullptr; }
+
+    /// @brief frame backed by slot i, order starts unset so the first publish always stages masses
+    frame slot(uint32_t i) const noexcept;
+
+    /// @brief Waits until no frame in flight still reads the slot of f, so it can be handed back to the simulation
+    void retire(const frame& f);
+
     private:
     static constexpr int MAX_FRAMES_IN_FLIGHT       = 2;
     GLFWwindow*                      window         = nullptr;
@@ -36,9 +59,18 @@ struct renderer {
     Swapchain      swapchain;
 
     CommandBuffer command;
-    FrameData frames[MAX_FRAMES_IN_FLIGHT];
+    FrameData frames[FRAME_SLOTS];
+    MassBuffer masses;
+    Compute compute;
+    bool simulate = false;
+    static_assert(Compute::SLOTS == FRAME_SLOTS);
     UBOBuffer uboBuffers[MAX_FRAMES_IN_FLIGHT];
 
+    // slot each frame in flight draws from, and the order of the masses on the device
+    int32_t  drawn[MAX_FRAMES_IN_FLIGHT] = { -1, -1 };
+    uint64_t massOrder = UINT64_MAX;
+    size_t   count = 0;
+
     vk::raii::PipelineLayout pipelineLayout   = nullptr;
     vk::raii::Pipeline       pipeline         = nullptr;
     vk::raii::CommandPool    commandPool      = nullptr;
@@ -73,9 +105,9 @@ struct renderer {
     void vulkan_command_buffer();
     void vulkan_sync_objects();
     void vulkan_init_descriptors();
-    void vulkan_write_descriptors(size_t i);
+    void vulkan_write_descriptors(size_t s, size_t i);
 
-    void vulkan_record_command_buffer(uint32_t imageIndex, size_t n);
+    void vulkan_record_command_buffer(uint32_t imageIndex, const frame& f);
     void transition_image_layout(
         uint32_t imageIndex,
         vk::ImageLayout oldLayout,
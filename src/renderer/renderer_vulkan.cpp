@@ -7,7 +7,7 @@ Comments: Most of this code is ripped from https://docs.vulkan.org/tutorial/late
 #include "renderer.hpp"
 #include <stdexcept>
 
-void renderer::init(const data& data, const std::string& exePath) {
+void renderer::init(const data& data, const std::string& exePath, bool simulate) {
     init_window();
     vulkan_instance();
     vulkan_surface();
@@ -17,10 +17,22 @@ void renderer::init(const data& data, const std::string& exePath) {
     vulkan_init_descriptors();
     vulkan_graphics_pipeline();
     vulkan_command_pool();
-    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) { 
-        frames[i].init(data, ldevice, pdevice);
-        uboBuffers[i].init(ldevice, pdevice);
-        vulkan_write_descriptors(i);
+
+    count = data.bodies();
+    masses.init(count, ldevice, pdevice);
+    for (size_t s = 0; s < FRAME_SLOTS; s++) { frames[s].init(data, ldevice, pdevice); }
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) { uboBuffers[i].init(ldevice, pdevice); }
+
+    // the gpu solver keeps its own device local render slots and uploads the masses itself
+    this->simulate = simulate;
+    if (simulate) {
+        compute.init(data, ldevice, pdevice, masses);
+        massOrder = data.order();
+    }
+
+    // one set per slot and frame in flight, positions come from the slot and the ubo from the frame
+    for (size_t s = 0; s < FRAME_SLOTS; s++) {
+        for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) { vulkan_write_descriptors(s, i); }
     }
     // TODO : reimplment below line eventually
     //command.init(ldevice, MAX_FRAMES_IN_FLIGHT);
@@ -258,13 +270,13 @@ void renderer::vulkan_sync_objects() {
 
 void renderer::vulkan_init_descriptors() {
     std::array<vk::DescriptorPoolSize, 2> poolSize {{
-        {.type = vk::DescriptorType::eStorageBuffer, .descriptorCount = 3 * MAX_FRAMES_IN_FLIGHT},
-        { .type = vk::DescriptorType::eUniformBuffer, .descriptorCount = 1 * MAX_FRAMES_IN_FLIGHT},
+        {.type = vk::DescriptorType::eStorageBuffer, .descriptorCount = 3 * FRAME_SLOTS * MAX_FRAMES_IN_FLIGHT},
+        { .type = vk::DescriptorType::eUniformBuffer, .descriptorCount = 1 * FRAME_SLOTS * MAX_FRAMES_IN_FLIGHT},
     }};
 
     descriptorPool = vk::raii::DescriptorPool(ldevice, vk::DescriptorPoolCreateInfo {
         .flags = vk::DescriptorPoolCreateFlagBits::eFreeDescriptorSet,
-        .maxSets       = MAX_FRAMES_IN_FLIGHT,
+        .maxSets       = FRAME_SLOTS * MAX_FRAMES_IN_FLIGHT,
         .poolSizeCount = poolSize.size(),
         .pPoolSizes    = poolSize.data(),
     });
@@ -281,27 +293,27 @@ void renderer::vulkan_init_descriptors() {
         .pBindings = bindings.data()
     });
 
-    std::vector<vk::DescriptorSetLayout> layouts(MAX_FRAMES_IN_FLIGHT, *descriptorSetLayout);
+    std::vector<vk::DescriptorSetLayout> layouts(FRAME_SLOTS * MAX_FRAMES_IN_FLIGHT, *descriptorSetLayout);
     vk::DescriptorSetAllocateInfo allocInfo {
         .descriptorPool = *descriptorPool,
-        .descriptorSetCount = MAX_FRAMES_IN_FLIGHT,
+        .descriptorSetCount = FRAME_SLOTS * MAX_FRAMES_IN_FLIGHT,
         .pSetLayouts = layouts.data()
     };
 
     descriptorSets = ldevice.Device().allocateDescriptorSets(allocInfo);
 }
 
-void renderer::vulkan_write_descriptors(size_t i) {
-    auto& s = frames[i];
+void renderer::vulkan_write_descriptors(size_t s, size_t i) {
+    auto& set = descriptorSets[s * MAX_FRAMES_IN_FLIGHT + i];
 
-    auto xInfo = s.xInfo();
-    auto yInfo = s.yInfo();
-    auto rInfo = s.rInfo();
+    auto xInfo = simulate ? compute.xInfo(s) : frames[s].xInfo();
+    auto yInfo = simulate ? compute.yInfo(s) : frames[s].yInfo();
+    auto rInfo = masses.Info();
     auto uInfo = uboBuffers[i].Info();
 
     std::array<vk::WriteDescriptorSet, 4> writes = {{
         {
-            .dstSet = *descriptorSets[i],
+            .dstSet = *set,
             .dstBinding = 0,
             .dstArrayElement = 0,
             .descriptorCount = 1,
@@ -309,7 +321,7 @@ void renderer::vulkan_write_descriptors(size_t i) {
             .pBufferInfo = &xInfo,
         },
         {
-            .dstSet = *descriptorSets[i],
+            .dstSet = *set,
             .dstBinding = 1,
             .dstArrayElement = 0,
             .descriptorCount = 1,
@@ -317,7 +329,7 @@ void renderer::vulkan_write_descriptors(size_t i) {
             .pBufferInfo = &yInfo,
         },
         {
-            .dstSet = *descriptorSets[i],
+            .dstSet = *set,
             .dstBinding = 2,
             .dstArrayElement = 0,
             .descriptorCount = 1,
@@ -325,7 +337,7 @@ void renderer::vulkan_write_descriptors(size_t i) {
             .pBufferInfo = &rInfo,
         },
         {
-            .dstSet = *descriptorSets[i],
+            .dstSet = *set,
             .dstBinding = 3,
             .dstArrayElement = 0,
             .descriptorCount = 1,
@@ -337,10 +349,19 @@ void renderer::vulkan_write_descriptors(size_t i) {
     ldevice.Device().updateDescriptorSets(writes, {});
 }
 
-void renderer::vulkan_record_command_buffer(uint32_t imageIndex, size_t n) {
+void renderer::vulkan_record_command_buffer(uint32_t imageIndex, const frame& f) {
     auto& cmd = commandBuffers[frameIndex];
     cmd.begin({});
 
+    // masses only move when the simulation reorders bodies
+    if (f.order != massOrder) {
+        masses.record_upload(cmd, frames[f.slot].MassStaging());
+        massOrder = f.order;
+    }
+
+    const uint32_t slot = f.slot;
+    drawn[frameIndex] = slot;
+
     transition_image_layout(
         imageIndex,
         vk::ImageLayout::eUndefined,
@@ -376,7 +397,7 @@ void renderer::vulkan_record_command_buffer(uint32_t imageIndex, size_t n) {
         vk::PipelineBindPoint::eGraphics,
         *pipelineLayout,
         0,
-        { *descriptorSets[frameIndex] },
+        { *descriptorSets[slot * MAX_FRAMES_IN_FLIGHT + frameIndex] },
         {}
     );
     cmd.setViewport(0, vk::Viewport(0.0f, 0.0f, static_cast<float>(swapchain.Extent().width), static_cast<float>(swapchain.Extent().height), 0.0f, 1.0f));
@@ -385,7 +406,7 @@ void renderer::vulkan_record_command_buffer(uint32_t imageIndex, size_t n) {
     struct PushConstants { glm::vec4 color; float softness; float width; float height; };
     PushConstants pc { {1.0f, 0.0f, 0.0f, 1.0f}, 0.02f, (float)swapchain.Extent().width, (float)swapchain.Extent().height };
     cmd.pushConstants<PushConstants>(*pipelineLayout, vk::ShaderStageFlagBits::eFragment | vk::ShaderStageFlagBits::eVertex, 0, pc);
-    cmd.draw(3, n, 0, 0);
+    cmd.draw(3, count, 0, 0);
     cmd.endRendering();
 
     transition_image_layout(
@@ -439,7 +460,23 @@ void renderer::transition_image_layout(
     commandBuffer.pipelineBarrier2(dependencyInfo);
 }
 
-std::chrono::nanoseconds renderer::render(const data& data, float dt) {
+renderer::frame renderer::slot(uint32_t i) const noexcept {
+    return { frames[i].X(), frames[i].Y(), frames[i].M(), UINT64_MAX, i };
+}
+
+void renderer::retire(const frame& f) {
+    for (size_t i = 0; i < MAX_FRAMES_IN_FLIGHT; i++) {
+        if (drawn[i] != (int32_t)f.slot) { continue; }
+
+        auto fenceResult = ldevice.Device().waitForFences(*inFlightFences[i], vk::True, UINT64_MAX);
+        if (fenceResult != vk::Result::eSuccess) {
+            throw std::runtime_error("failed to wait for fence");
+        }
+        drawn[i] = -1;
+    }
+}
+
+std::chrono::nanoseconds renderer::render(const frame& f, float dt) {
     auto s = std::chrono::high_resolution_clock::now();
     glfwPollEvents();
     cam.update(window, dt);
@@ -459,7 +496,6 @@ std::chrono::nanoseconds renderer::render(const data& data, float dt) {
 
     ldevice.Device().resetFences(*inFlightFences[frameIndex]);
 
-    frames[frameIndex].update(data);
     UBO ubo {
         .view = cam.viewMatrix(),
         .proj = cam.projMatrix(swapchain.Extent().width, swapchain.Extent().height)
@@ -467,7 +503,7 @@ std::chrono::nanoseconds renderer::render(const data& data, float dt) {
     uboBuffers[frameIndex].update(ubo);
 
     commandBuffers[frameIndex].reset();
-    vulkan_record_command_buffer(imageIndex, data.bodies());
+    vulkan_record_command_buffer(imageIndex, f);
 
     vk::PipelineStageFlags waitDestinationStageMask(vk::PipelineStageFlagBits::eColorAttachmentOutput);
     const vk::SubmitInfo submitInfo {
@@ -480,8 +516,6 @@ std::chrono::nanoseconds renderer::render(const data& data, float dt) {
         .pSignalSemaphores = &*renderFinishedSemaphores[imageIndex]
     };
 
-    ldevice.Queue().submit(submitInfo, *inFlightFences[frameIndex]);
-
     const vk::PresentInfoKHR presentInfoKHR {
         .waitSemaphoreCount = 1,
         .pWaitSemaphores = &*renderFinishedSemaphores[imageIndex],
@@ -490,7 +524,12 @@ std::chrono::nanoseconds renderer::render(const data& data, float dt) {
         .pImageIndices = &imageIndex
     };
 
-    result = ldevice.Queue().presentKHR(presentInfoKHR);
+    {
+        // the compute solver submits on the same queue from the simulation thread
+        std::lock_guard<std::mutex> lock(ldevice.QueueLock());
+        ldevice.Queue().submit(submitInfo, *inFlightFences[frameIndex]);
+        result = ldevice.Queue().presentKHR(presentInfoKHR);
+    }
     if (result == vk::Result::eSuboptimalKHR || result == vk::Result::eErrorOutOfDateKHR || framebufferResized) {
         framebufferResized = false;
         swapchain.recreate(pdevice, ldevice, surface, window);
@@ -501,7 +540,10 @@ std::chrono::nanoseconds renderer::render(const data& data, float dt) {
 }
 
 void renderer::cleanup() {
-    ldevice.Device().waitIdle();
+    {
+        std::lock_guard<std::mutex> lock(ldevice.QueueLock());
+        ldevice.Device().waitIdle();
+    }
 
     if (window) { glfwDestroyWindow(window); }
     glfwTerminate();
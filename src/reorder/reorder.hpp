@@ -0,0 +1,104 @@
+#pragma once
+#include <bit>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "../data/data.hpp"
+#include "../simd/simd.hpp"
+#include "../sort/radix.hpp"
+
+/// @brief Reorders bodies by a key computed per body, keys are radix sorted and the data gathered into the
+/// sorted order. Key, index and sort scratch are kept between calls so reordering every step allocates nothing
+struct reorder {
+    public:
+    /// @brief fills keys[i] for body i and sets idxs to identity, bodies are reordered by ascending key
+    using key_fn = void (*)(const data& d, uint64_t* keys, uint32_t* idxs) noexcept;
+
+    enum ordering { MORTON, HILBERT, RADIUS };
+
+    // default constructor
+    reorder() : key_(&reorder::morton), ordering_(MORTON) {}
+
+    // custom constructor
+    reorder(ordering o) : key_(key(o)), ordering_(o) {}
+
+    /// @brief Parses an ordering name from the config
+    /// @param name One of morton, hilbert, radius
+    static ordering parse(const std::string& name) {
+        if (name == "morton" || name == "zcurve") { return MORTON; }
+        if (name == "hilbert") { return HILBERT; }
+        if (name == "radius") { return RADIUS; }
+        throw std::runtime_error("invalid ordering \"" + name + "\"");
+    }
+
+    static key_fn key(ordering o) noexcept {
+        switch (o) {
+            case HILBERT: return &reorder::hilbert;
+            case RADIUS: return &reorder::radius;
+            default: return &reorder::morton;
+        }
+    }
+
+    constexpr ordering type() const noexcept { return ordering_; }
+
+    /// @brief key of the body now at position i, only valid after sort
+    inline uint64_t code(size_t i) const noexcept { return keys_[i]; }
+
+    /// @brief Computes keys, sorts them and gathers every array of d into the new order
+    inline void sort(data& d) noexcept {
+        const size_t n = d.bodies();
+        keys_.resize(n);
+        idxs_.resize(n);
+
+        key_(d, keys_.data(), idxs_.data());
+        sorter_.sort(keys_, idxs_);
+        d.permute(idxs_.data());
+    }
+
+    /// @brief Z order of the positions normalized into their bounding box, see simd::table::encode
+    static void morton(const data& d, uint64_t* keys, uint32_t* idxs) noexcept {
+        curve(d, keys, idxs, simd::active().encode);
+    }
+
+    /// @brief Hilbert order over the same box, consecutive bodies never jump between distant quadrants
+    static void hilbert(const data& d, uint64_t* keys, uint32_t* idxs) noexcept {
+        curve(d, keys, idxs, simd::active().hilbert);
+    }
+
+    /// @brief Distance from the origin, squared distance is never negative so its bits order the same as its value
+    static void radius(const data& d, uint64_t* keys, uint32_t* idxs) noexcept {
+        const size_t n = d.bodies();
+        const float* __restrict px = d.posx();
+        const float* __restrict py = d.posy();
+
+        #pragma omp parallel for simd schedule(static)
+        for (size_t i = 0; i < n; i++) {
+            keys[i] = std::bit_cast<uint32_t>(px[i]*px[i] + py[i]*py[i]);
+            idxs[i] = i;
+        }
+    }
+
+    private:
+    using curve_fn = decltype(simd::table::encode);
+
+    /// @brief Space filling curve keys of the positions normalized into their bounding box
+    static inline void curve(const data& d, uint64_t* keys, uint32_t* idxs, curve_fn encode) noexcept {
+        const size_t n = d.bodies();
+
+        float box[4];
+        simd::active().bounds(d.posx(), d.posy(), n, box);
+
+        const float rx = (box[2] > box[0]) ? (box[2] - box[0]) : 1.0f;
+        const float ry = (box[3] > box[1]) ? (box[3] - box[1]) : 1.0f;
+
+        encode(d.posx(), d.posy(), n, box[0], box[1], rx, ry, keys, idxs);
+    }
+
+    key_fn key_;
+    ordering ordering_;
+    std::vector<uint64_t> keys_;
+    std::vector<uint32_t> idxs_;
+    radix sorter_;
+};
@@ -0,0 +1,94 @@
+#pragma once
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+/// @brief Decides which steps reorder the bodies. Between reorders the tree keeps the topology of the last
+/// sort and only refits its boxes and centers of mass, which stays exact as the opening tests use the refit boxes
+/// but lets nodes loosen as bodies drift. The walk's interaction count is the locality metric, it is free to
+/// measure and rises with the overlap of loose nodes, so it tracks kernel time without the timer noise
+struct resort {
+    public:
+    enum mode { ALWAYS, INTERVAL, ADAPTIVE };
+
+    // default constructor
+    resort() : mode_(ALWAYS), interval_(1), threshold_(0.0f) { restart(); }
+
+    // custom constructor
+    resort(mode m, size_t interval, float threshold) : mode_(m), interval_(interval ? interval : 1), threshold_(threshold) { restart(); }
+
+    // copies carry the settings only, the state describes a tree that is not copied with them
+    resort(const resort& other) noexcept : mode_(other.mode_), interval_(other.interval_), threshold_(other.threshold_) { restart(); }
+
+    resort& operator = (const resort& other) noexcept {
+        mode_ = other.mode_;
+        interval_ = other.interval_;
+        threshold_ = other.threshold_;
+        restart();
+        return *this;
+    }
+
+    /// @brief Parses a policy name from the config
+    /// @param name One of always, interval, adaptive
+    static mode parse(const std::string& name) {
+        if (name == "always") { return ALWAYS; }
+        if (name == "interval") { return INTERVAL; }
+        if (name == "adaptive") { return ADAPTIVE; }
+        throw std::runtime_error("invalid resort policy \"" + name + "\"");
+    }
+
+    constexpr mode type() const noexcept { return mode_; }
+    constexpr const char* name() const noexcept {
+        switch (mode_) {
+            case INTERVAL: return "interval";
+            case ADAPTIVE: return "adaptive";
+            default: return "always";
+        }
+    }
+
+    /// @brief work of the last step relative to the first one after the last reorder
+    constexpr float drift() const noexcept { return drift_; }
+
+    /// @brief Makes the next step reorder, for when the tree was rebuilt or dropped outside the policy
+    inline void restart() noexcept {
+        since_ = 0;
+        base_ = 0;
+        drift_ = 0.0f;
+        fresh_ = true;
+    }
+
+    /// @brief Called once before every step, true when the step's first tree build should reorder the bodies
+    inline bool next() noexcept {
+        bool sort = fresh_;
+        switch (mode_) {
+            case ALWAYS: sort = true; break;
+            case INTERVAL: sort |= since_ >= interval_; break;
+            case ADAPTIVE: sort |= drift_ > threshold_; break;
+        }
+
+        if (sort) {
+            since_ = 0;
+            base_ = 0;
+            drift_ = 0.0f;
+            fresh_ = false;
+        }
+        since_++;
+        return sort;
+    }
+
+    /// @brief Called after every step with the interactions of all its force evaluations
+    inline void measure(size_t work) noexcept {
+        if (base_ == 0) { base_ = work; return; }
+        drift_ = (float)work / (float)base_ - 1.0f;
+    }
+
+    private:
+    mode mode_;
+    size_t interval_;       // steps between reorders in interval mode
+    float threshold_;       // relative rise in work that triggers a reorder in adaptive mode
+
+    size_t since_;          // steps since the last reorder, including it
+    size_t base_;           // work of the first step after the last reorder
+    float drift_;
+    bool fresh_;            // no tree has been sorted for the current bodies
+};
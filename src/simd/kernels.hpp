@@ -0,0 +1,656 @@
+#pragma once
+
+/*
+Kernel definitions shared by every per isa source, which defines SIMD_ISA as the namespace to build them in and
+includes this once. Nothing here may use a definition with external linkage such as a standard library template,
+the copy compiled with wider flags could otherwise be the one the linker keeps for the rest of the program
+*/
+
+#include <cstddef>
+#include <cstdint>
+#include <omp.h>
+#include <sys/types.h>
+
+#include "simd.hpp"
+#include "lanes.hpp"
+
+#ifndef SIMD_ISA
+#error "SIMD_ISA must name the namespace the kernels are built in"
+#endif
+
+namespace simd::SIMD_ISA {
+    static inline size_t smin(size_t a, size_t b) { return a < b ? a : b; }
+
+    /// @brief spreads the low 16 bits of v into the even bits of a 32 bit word
+    static inline uint32_t spread(uint32_t v) {
+        v = (v | (v << 8)) & 0x00FF00FFu;
+        v = (v | (v << 4)) & 0x0F0F0F0Fu;
+        v = (v | (v << 2)) & 0x33333333u;
+        v = (v | (v << 1)) & 0x55555555u;
+        return v;
+    }
+
+    /// @brief spreads the low 32 bits of v into the even bits of a 64 bit word
+    static inline uint64_t spread32(uint64_t v) {
+        v = (v | (v << 16)) & 0x0000FFFF0000FFFFull;
+        v = (v | (v << 8)) & 0x00FF00FF00FF00FFull;
+        v = (v | (v << 4)) & 0x0F0F0F0F0F0F0F0Full;
+        v = (v | (v << 2)) & 0x3333333333333333ull;
+        v = (v | (v << 1)) & 0x5555555555555555ull;
+        return v;
+    }
+
+    /// @brief one round of the hilbert prefix scan, combines the transforms of bit pairs s apart
+    template<uint64_t s>
+    static inline void hilbert_round(uint64_t& A, uint64_t& B, uint64_t& C, uint64_t& D) {
+        const uint64_t a = A, b = B, c = C, d = D;
+        A = (a & (a >> s)) ^ (b & (b >> s));
+        B = (a & (b >> s)) ^ (b & ((a ^ b) >> s));
+        C ^= (a & (c >> s)) ^ (b & (d >> s));
+        D ^= (b & (c >> s)) ^ ((a ^ b) & (d >> s));
+    }
+
+    /// @brief Hilbert index of two 32 bit coordinates. The usual per level state machine is rewritten as a parallel
+    /// prefix scan over the bits, so it takes log2(32) rounds of shifts and masks instead of 32 dependent table
+    /// lookups. Keys of bodies in the same quadrant at level k share their top 2k bits, as morton keys do
+    static inline uint64_t hilbert_index(uint64_t x, uint64_t y) {
+        constexpr uint64_t m = 0xFFFFFFFFull;
+
+        // first round, primed with the coordinate bits
+        uint64_t a = x ^ y;
+        uint64_t b = m ^ a;
+        uint64_t c = m ^ (x | y);
+        uint64_t d = x & (y ^ m);
+
+        uint64_t A = a | (b >> 1);
+        uint64_t B = (a >> 1) ^ a;
+        uint64_t C = ((c >> 1) ^ (b & (d >> 1))) ^ c;
+        uint64_t D = ((a & (c >> 1)) ^ (d >> 1)) ^ d;
+
+        // unrolled by hand, a loop here keeps the calling loop from vectorizing
+        hilbert_round<2>(A, B, C, D);
+        hilbert_round<4>(A, B, C, D);
+        hilbert_round<8>(A, B, C, D);
+        hilbert_round<16>(A, B, C, D);
+
+        // undo the scan and recover the two index bits of every level
+        a = C ^ (C >> 1);
+        b = D ^ (D >> 1);
+        const uint64_t i0 = x ^ y;
+        const uint64_t i1 = b | (m ^ (i0 | a));
+
+        return (spread32(i1) << 1) | spread32(i0);
+    }
+
+    /// @brief Generic custom simd update function, uses newtons third law and accumulates into one
+    /// acceleration row per thread
+    static void attract_rows(const float* __restrict px, const float* __restrict py, const float* __restrict ma,
+                             float* ax, float* ay, size_t stride, size_t n) {
+        // gravitational constant is set to 1 for purposes of this simulation
+        #pragma omp parallel
+        {
+            int tid = omp_get_thread_num();
+            float* __restrict ax_row = ax + tid * stride;
+            float* __restrict ay_row = ay + tid * stride;
+
+            #pragma omp for schedule(static)
+            for (size_t i = 0; i < n; i++) {
+                const float p1x = px[i];
+                const float p1y = py[i];
+                const float p1m = ma[i];
+
+                const auto _p1x = simd::set1(p1x);
+                const auto _p1y = simd::set1(p1y);
+                const auto _p1m = simd::set1(p1m);
+
+                auto _a1x_sum = simd::zero();
+                auto _a1y_sum = simd::zero();
+
+                size_t j = i+1;
+                for (; j+simd::last < n; j += simd::width) {
+                    const auto _p2x = simd::loadu(&px[j]);
+                    const auto _p2y = simd::loadu(&py[j]);
+                    const auto _p2m = simd::loadu(&ma[j]);
+
+                    // compute distance squared
+                    const auto _dx = _p2x - _p1x;
+                    const auto _dy = _p2y - _p1y;
+                    const auto _dsq = simd::epsl() + (_dx*_dx) + (_dy*_dy);
+
+                    // fast inv sqrt with newton step
+                    const auto _inv = simd::rsqrt(_dsq);
+                    const auto _inv3 = _inv * _inv * _inv;
+
+                    // compute intermediate values
+                    const auto _ivx = _dx * _inv3;
+                    const auto _ivy = _dy * _inv3;
+
+                    // compute and store accelerations
+                    simd::storeu(&ax_row[j], simd::loadu(&ax_row[j]) - (_ivx * _p1m));
+                    simd::storeu(&ay_row[j], simd::loadu(&ay_row[j]) - (_ivy * _p1m));
+                    _a1x_sum += _ivx * _p2m;
+                    _a1y_sum += _ivy * _p2m;
+                }
+
+                float a1x_final = simd::hsum(_a1x_sum);
+                float a1y_final = simd::hsum(_a1y_sum);
+
+                // remainder handling
+                for(; j < n; j++) {
+                    const float p2x = px[j];
+                    const float p2y = py[j];
+                    const float p2m = ma[j];
+
+                    const float dx = p2x - p1x;
+                    const float dy = p2y - p1y;
+                    const float dsq = 1e-12f + (dx*dx) + (dy*dy);
+
+                    // fast rsqrt with netwon step
+                    float inv = simd::frsqrt(dsq);
+                    inv = inv * (1.5f - 0.5f * dsq * inv * inv);
+
+                    // compute intermediate values
+                    float inv_dis3 = inv * inv * inv;
+                    float ivx = dx * inv_dis3;
+                    float ivy = dy * inv_dis3;
+
+                    // update acceleration values
+                    a1x_final += ivx * p2m;
+                    a1y_final += ivy * p2m;
+                    ax_row[j] -= ivx * p1m;
+                    ay_row[j] -= ivy * p1m;
+                }
+
+                // earlier bodies on this thread have already written into this body
+                ax_row[i] += a1x_final;
+                ay_row[i] += a1y_final;
+            }
+        }
+    }
+
+    /// @brief Tiled simd update function, every body sums its full row of interactions so no per
+    /// thread acceleration rows are needed, j tiles are sized to stay resident in cache while an i tile
+    /// streams over them
+    /// @tparam fused Also kick and drift each tile, writing positions into the shadow arrays
+    /// @tparam precise Add the difference of the position errors to every dx and dy, the difference of the float
+    /// positions is exact for nearby bodies so close pairs keep their precision far from the origin
+    template<bool fused, bool precise>
+    static void attract_tiles(const tile_args& a) {
+        constexpr size_t itile = 64;
+        constexpr size_t jtile = 2048;
+        static_assert(jtile % simd::width == 0);
+
+        // aliasing
+        const size_t n = a.n;
+        const float ft = a.ft;
+        const uint32_t* __restrict idx = a.idx;
+        const float* __restrict ma = a.ma;
+        const float* __restrict px = a.px;
+        const float* __restrict py = a.py;
+        const float* __restrict pxl = a.pxl;
+        const float* __restrict pyl = a.pyl;
+        float* __restrict ax = a.ax;
+        float* __restrict ay = a.ay;
+        float* __restrict vx = a.vx;
+        float* __restrict vy = a.vy;
+        float* __restrict npx = a.npx;
+        float* __restrict npy = a.npy;
+        float* __restrict npxl = a.npxl;
+        float* __restrict npyl = a.npyl;
+
+        const size_t count = a.count;
+        const size_t tiles = (count + itile - 1) / itile;
+
+        // gravitational constant is set to 1 for purposes of this simulation
+        #pragma omp parallel for schedule(static)
+        for (size_t t = 0; t < tiles; t++) {
+            const size_t ib = t * itile;
+            const size_t ie = smin(ib + itile, count);
+
+            // per body partial sums kept across j tiles
+            simd::reg _ax[itile];
+            simd::reg _ay[itile];
+            float rx[itile];
+            float ry[itile];
+
+            for (size_t i = 0; i < ie - ib; i++) {
+                _ax[i] = simd::zero();
+                _ay[i] = simd::zero();
+                rx[i] = 0.0f;
+                ry[i] = 0.0f;
+            }
+
+            for (size_t jb = 0; jb < n; jb += jtile) {
+                const size_t je = smin(jb + jtile, n);
+
+                for (size_t k = ib; k < ie; k++) {
+                    const size_t i = idx ? idx[k] : k;
+                    const float p1x = px[i];
+                    const float p1y = py[i];
+                    const float p1xl = precise ? pxl[i] : 0.0f;
+                    const float p1yl = precise ? pyl[i] : 0.0f;
+
+                    const auto _p1x = simd::set1(p1x);
+                    const auto _p1y = simd::set1(p1y);
+                    const auto _p1xl = simd::set1(p1xl);
+                    const auto _p1yl = simd::set1(p1yl);
+
+                    auto _a1x_sum = _ax[k-ib];
+                    auto _a1y_sum = _ay[k-ib];
+
+                    // self interaction is zero as dx and dy are zero
+                    size_t j = jb;
+                    for (; j+simd::last < je; j += simd::width) {
+                        const auto _p2x = simd::loadu(&px[j]);
+                        const auto _p2y = simd::loadu(&py[j]);
+                        const auto _p2m = simd::loadu(&ma[j]);
+
+                        // compute distance squared
+                        auto _dx = _p2x - _p1x;
+                        auto _dy = _p2y - _p1y;
+                        if constexpr (precise) {
+                            simd::opaque(_dx);
+                            simd::opaque(_dy);
+                            _dx += simd::loadu(&pxl[j]) - _p1xl;
+                            _dy += simd::loadu(&pyl[j]) - _p1yl;
+                        }
+                        const auto _dsq = simd::epsl() + (_dx*_dx) + (_dy*_dy);
+
+                        // fast inv sqrt with newton step
+                        const auto _inv = simd::rsqrt(_dsq);
+                        const auto _inv3 = _inv * _inv * _inv * _p2m;
+
+                        _a1x_sum += _dx * _inv3;
+                        _a1y_sum += _dy * _inv3;
+                    }
+
+                    _ax[k-ib] = _a1x_sum;
+                    _ay[k-ib] = _a1y_sum;
+
+                    // remainder handling, only the last j tile has one
+                    for (; j < je; j++) {
+                        float dx = px[j] - p1x;
+                        float dy = py[j] - p1y;
+                        if constexpr (precise) {
+                            simd::fopaque(dx);
+                            simd::fopaque(dy);
+                            dx += pxl[j] - p1xl;
+                            dy += pyl[j] - p1yl;
+                        }
+                        const float dsq = 1e-12f + (dx*dx) + (dy*dy);
+
+                        // fast rsqrt with netwon step
+                        float inv = simd::frsqrt(dsq);
+                        inv = inv * (1.5f - 0.5f * dsq * inv * inv);
+
+                        const float inv3 = inv * inv * inv * ma[j];
+                        rx[k-ib] += dx * inv3;
+                        ry[k-ib] += dy * inv3;
+                    }
+                }
+            }
+
+            for (size_t k = ib; k < ie; k++) {
+                const size_t i = idx ? idx[k] : k;
+                ax[i] = simd::hsum(_ax[k-ib]) + rx[k-ib];
+                ay[i] = simd::hsum(_ay[k-ib]) + ry[k-ib];
+            }
+
+            // fused steps always cover every body in order, so k and i match
+            if constexpr (fused) {
+                #pragma omp simd
+                for (size_t i = ib; i < ie; i++) {
+                    vx[i] += ax[i] * ft;
+                    vy[i] += ay[i] * ft;
+
+                    if constexpr (precise) {
+                        // same split as integrator::drift_precise
+                        const double x = (double)px[i] + pxl[i] + (double)vx[i] * ft;
+                        const double y = (double)py[i] + pyl[i] + (double)vy[i] * ft;
+                        npx[i] = (float)x;
+                        npy[i] = (float)y;
+                        npxl[i] = (float)(x - npx[i]);
+                        npyl[i] = (float)(y - npy[i]);
+                    } else {
+                        npx[i] = px[i] + vx[i] * ft;
+                        npy[i] = py[i] + vy[i] * ft;
+                    }
+                }
+            }
+        }
+    }
+
+    /// @brief v += a * dt
+    static void kick(float* __restrict vx, float* __restrict vy, const float* ax, const float* ay, float dt, size_t n) {
+        const auto _dt = simd::set1(dt);
+
+        // full vectors end at r, openmp needs the bound as a plain i < r
+        const size_t r = n - (n%simd::width);
+
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < r; i += simd::width) {
+            simd::store(vx+i, simd::load(vx+i) + simd::load(&ax[i]) * _dt);
+            simd::store(vy+i, simd::load(vy+i) + simd::load(&ay[i]) * _dt);
+        }
+
+        for (size_t i = r; i < n; i++) {
+            vx[i] += ax[i] * dt;
+            vy[i] += ay[i] * dt;
+        }
+    }
+
+    /// @brief x += v * dt
+    static void drift(float* __restrict px, float* __restrict py, const float* __restrict vx, const float* __restrict vy, float dt, size_t n) {
+        const auto _dt = simd::set1(dt);
+
+        const size_t r = n - (n%simd::width);
+
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < r; i += simd::width) {
+            simd::store(px+i, simd::load(px+i) + simd::load(vx+i) * _dt);
+            simd::store(py+i, simd::load(py+i) + simd::load(vy+i) * _dt);
+        }
+
+        for (size_t i = r; i < n; i++) {
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+        }
+    }
+
+    /// @brief v += a * dt then x += v * dt in a single pass
+    static void kick_drift(float* __restrict px, float* __restrict py, float* __restrict vx, float* __restrict vy,
+                           const float* ax, const float* ay, float dt, size_t n) {
+        const auto _dt = simd::set1(dt);
+
+        const size_t r = n - (n%simd::width);
+
+        #pragma omp parallel for schedule(static)
+        for (size_t i = 0; i < r; i += simd::width) {
+            const auto _ax = simd::load(&ax[i]);
+            const auto _ay = simd::load(&ay[i]);
+            auto _vx = simd::load(vx+i);
+            auto _vy = simd::load(vy+i);
+            auto _px = simd::load(px+i);
+            auto _py = simd::load(py+i);
+
+            _vx += _ax * _dt;
+            _vy += _ay * _dt;
+            _px += _vx * _dt;
+            _py += _vy * _dt;
+
+            simd::store(vx+i, _vx);
+            simd::store(vy+i, _vy);
+            simd::store(px+i, _px);
+            simd::store(py+i, _py);
+        }
+
+        for (size_t i = r; i < n; i++) {
+            vx[i] += ax[i] * dt;
+            vy[i] += ay[i] * dt;
+
+            px[i] += vx[i] * dt;
+            py[i] += vy[i] * dt;
+        }
+    }
+
+    /// @brief Bounding box of the bodies in a single pass over both axes
+    static void bounds(const float* __restrict px, const float* __restrict py, size_t n, float* box) {
+        constexpr float big = 3.4e38f;
+        float minx = big, miny = big, maxx = -big, maxy = -big;
+        const size_t blocks = n / simd::width;
+
+        #pragma omp parallel reduction(min:minx, miny) reduction(max:maxx, maxy)
+        {
+            auto _minx = simd::set1(big);
+            auto _miny = simd::set1(big);
+            auto _maxx = simd::set1(-big);
+            auto _maxy = simd::set1(-big);
+
+            #pragma omp for schedule(static) nowait
+            for (size_t b = 0; b < blocks; b++) {
+                const auto _px = simd::loadu(&px[b * simd::width]);
+                const auto _py = simd::loadu(&py[b * simd::width]);
+                _minx = simd::min(_minx, _px);
+                _miny = simd::min(_miny, _py);
+                _maxx = simd::max(_maxx, _px);
+                _maxy = simd::max(_maxy, _py);
+            }
+
+            float lanes[4][simd::width];
+            simd::storeu(lanes[0], _minx);
+            simd::storeu(lanes[1], _miny);
+            simd::storeu(lanes[2], _maxx);
+            simd::storeu(lanes[3], _maxy);
+
+            for (size_t k = 0; k < simd::width; k++) {
+                minx = lanes[0][k] < minx ? lanes[0][k] : minx;
+                miny = lanes[1][k] < miny ? lanes[1][k] : miny;
+                maxx = lanes[2][k] > maxx ? lanes[2][k] : maxx;
+                maxy = lanes[3][k] > maxy ? lanes[3][k] : maxy;
+            }
+        }
+
+        // remainder handling
+        for (size_t i = blocks * simd::width; i < n; i++) {
+            minx = px[i] < minx ? px[i] : minx;
+            miny = py[i] < miny ? py[i] : miny;
+            maxx = px[i] > maxx ? px[i] : maxx;
+            maxy = py[i] > maxy ? py[i] : maxy;
+        }
+
+        box[0] = minx;
+        box[1] = miny;
+        box[2] = maxx;
+        box[3] = maxy;
+    }
+
+    /// @brief Magic bits morton encoder, each coordinate is quantized to 32 bits as a high and a low 16 bit half
+    /// so every body stays in one 32 bit lane, the halves are spread and interleaved separately and joined into
+    /// 64 bit keys on the store. All steps are exact in float so every isa produces the same keys
+    static void encode(const float* __restrict px, const float* __restrict py, size_t n, float minx, float miny, float rx, float ry,
+                       uint64_t* __restrict keys, uint32_t* __restrict idxs) {
+        // normalized coordinates are clamped just below 1 so the high half never reaches 65536
+        const float below = 0.99999994f;
+        const float sx = 1.0f / rx;
+        const float sy = 1.0f / ry;
+        const size_t blocks = n / simd::width;
+
+        const auto _minx = simd::set1(minx);
+        const auto _miny = simd::set1(miny);
+        const auto _sx = simd::set1(sx);
+        const auto _sy = simd::set1(sy);
+        const auto _zero = simd::zero();
+        const auto _below = simd::set1(below);
+        const auto _half = simd::set1(65536.0f);
+
+        #pragma omp parallel for schedule(static)
+        for (size_t b = 0; b < blocks; b++) {
+            const size_t i = b * simd::width;
+
+            // get normalized x, y values scaled by 2^16
+            const auto _qx = simd::min(simd::max((simd::loadu(&px[i]) - _minx) * _sx, _zero), _below) * _half;
+            const auto _qy = simd::min(simd::max((simd::loadu(&py[i]) - _miny) * _sy, _zero), _below) * _half;
+
+            const auto _hx = simd::cvtt(_qx);
+            const auto _hy = simd::cvtt(_qy);
+            const auto _lx = simd::cvtt((_qx - simd::cvt(_hx)) * _half);
+            const auto _ly = simd::cvtt((_qy - simd::cvt(_hy)) * _half);
+
+            const auto _hi = simd::interleave(simd::spread16(_hx), simd::spread16(_hy));
+            const auto _lo = simd::interleave(simd::spread16(_lx), simd::spread16(_ly));
+            simd::store_keys(&keys[i], _lo, _hi);
+
+            for (size_t k = i; k < i + simd::width; k++) { idxs[k] = k; }
+        }
+
+        // remainder handling, same steps one body at a time
+        for (size_t i = blocks * simd::width; i < n; i++) {
+            float tx = (px[i] - minx) * sx;
+            float ty = (py[i] - miny) * sy;
+            tx = (tx > 0.0f ? (tx < below ? tx : below) : 0.0f) * 65536.0f;
+            ty = (ty > 0.0f ? (ty < below ? ty : below) : 0.0f) * 65536.0f;
+
+            const uint32_t hx = (uint32_t)tx;
+            const uint32_t hy = (uint32_t)ty;
+            const uint32_t lx = (uint32_t)((tx - (float)hx) * 65536.0f);
+            const uint32_t ly = (uint32_t)((ty - (float)hy) * 65536.0f);
+
+            keys[i] = ((uint64_t)(spread(hx) | (spread(hy) << 1)) << 32) | (spread(lx) | (spread(ly) << 1));
+            idxs[i] = i;
+        }
+    }
+
+    /// @brief Hilbert curve encoder over the same 32 bit quantization as encode, the index is computed with 64 bit
+    /// integer ops only and left to the compiler to vectorize for each isa
+    static void hilbert(const float* __restrict px, const float* __restrict py, size_t n, float minx, float miny, float rx, float ry,
+                        uint64_t* __restrict keys, uint32_t* __restrict idxs) {
+        const float below = 0.99999994f;
+        const float sx = 1.0f / rx;
+        const float sy = 1.0f / ry;
+
+        #pragma omp parallel for simd schedule(static)
+        for (size_t i = 0; i < n; i++) {
+            float tx = (px[i] - minx) * sx;
+            float ty = (py[i] - miny) * sy;
+            tx = (tx > 0.0f ? (tx < below ? tx : below) : 0.0f) * 65536.0f;
+            ty = (ty > 0.0f ? (ty < below ? ty : below) : 0.0f) * 65536.0f;
+
+            const uint32_t hx = (uint32_t)tx;
+            const uint32_t hy = (uint32_t)ty;
+            const uint32_t lx = (uint32_t)((tx - (float)hx) * 65536.0f);
+            const uint32_t ly = (uint32_t)((ty - (float)hy) * 65536.0f);
+
+            keys[i] = hilbert_index(((uint64_t)hx << 16) | lx, ((uint64_t)hy << 16) | ly);
+            idxs[i] = i;
+        }
+    }
+
+    /// @brief Sum of -m1 m2 / r over every pair, each pair is visited once from its lower index
+    /// @tparam precise Add the difference of the position errors to every pair as attract_tiles does
+    template<bool precise>
+    static double potential(const float* __restrict px, const float* __restrict py, const float* __restrict pxl, const float* __restrict pyl,
+                            const float* __restrict ma, size_t n, size_t threads) {
+        double pot = 0.0;
+
+        // rows shrink with i, small chunks keep the team balanced
+        #pragma omp parallel for num_threads(threads) schedule(dynamic, 64) reduction(+:pot)
+        for (size_t i = 0; i < n; i++) {
+            const float p1xl = precise ? pxl[i] : 0.0f;
+            const float p1yl = precise ? pyl[i] : 0.0f;
+            const auto _p1x = simd::set1(px[i]);
+            const auto _p1y = simd::set1(py[i]);
+            const auto _p1xl = simd::set1(p1xl);
+            const auto _p1yl = simd::set1(p1yl);
+            auto _sum = simd::zero();
+
+            size_t j = i+1;
+            for (; j+simd::last < n; j += simd::width) {
+                auto _dx = simd::loadu(&px[j]) - _p1x;
+                auto _dy = simd::loadu(&py[j]) - _p1y;
+                if constexpr (precise) {
+                    simd::opaque(_dx);
+                    simd::opaque(_dy);
+                    _dx += simd::loadu(&pxl[j]) - _p1xl;
+                    _dy += simd::loadu(&pyl[j]) - _p1yl;
+                }
+                const auto _dsq = simd::epsl() + (_dx*_dx) + (_dy*_dy);
+
+                _sum += simd::rsqrt(_dsq) * simd::loadu(&ma[j]);
+            }
+
+            float sum = simd::hsum(_sum);
+
+            // remainder handling
+            for (; j < n; j++) {
+                float dx = px[j] - px[i];
+                float dy = py[j] - py[i];
+                if constexpr (precise) {
+                    simd::fopaque(dx);
+                    simd::fopaque(dy);
+                    dx += pxl[j] - p1xl;
+                    dy += pyl[j] - p1yl;
+                }
+                const float dsq = 1e-12f + (dx*dx) + (dy*dy);
+
+                // fast rsqrt with netwon step
+                float inv = simd::frsqrt(dsq);
+                inv = inv * (1.5f - 0.5f * dsq * inv * inv);
+                sum += inv * ma[j];
+            }
+
+            pot -= (double)ma[i] * sum;
+        }
+
+        return pot;
+    }
+
+    static size_t short_range(const cell_args& a, size_t c) {
+        const float* __restrict sx = a.sx;
+        const float* __restrict sy = a.sy;
+        const float* __restrict sm = a.sm;
+        const float* __restrict factor = a.factor;
+        const uint32_t* start = a.start;
+        const size_t g = a.grid;
+
+        // distances are compared squared and scaled into table samples
+        const float tmax = (float)a.samples;
+        const float tscale = tmax / a.rcsq;
+        const float rcsq = a.rcsq;
+
+        const size_t cx = c % g;
+        const size_t cy = c / g;
+        const size_t x0 = cx > a.reach ? cx - a.reach : 0;
+        const size_t x1 = smin(cx + a.reach, g-1);
+        const size_t y0 = cy > a.reach ? cy - a.reach : 0;
+        const size_t y1 = smin(cy + a.reach, g-1);
+
+        size_t interactions = 0;
+        for (size_t k = start[c]; k < start[c+1]; k++) {
+            const float p1x = sx[k];
+            const float p1y = sy[k];
+            float a1x = 0.0f;
+            float a1y = 0.0f;
+
+            for (size_t y = y0; y <= y1; y++) {
+                const size_t first = start[y*g + x0];
+                const size_t last = start[y*g + x1 + 1];
+                interactions += last - first;
+
+                // same softened pair kernel as attract_points, weighted by the short range factor
+                #pragma omp simd reduction(+:a1x, a1y)
+                for (size_t j = first; j < last; j++) {
+                    const float dx = sx[j] - p1x;
+                    const float dy = sy[j] - p1y;
+                    const float dsq = 1e-12f + (dx*dx) + (dy*dy);
+
+                    const float t = dsq * tscale < tmax ? dsq * tscale : tmax;
+                    const size_t s = (size_t)t;
+                    const float f = dsq < rcsq ? factor[s] + (t - s) * (factor[s+1] - factor[s]) : 0.0f;
+
+                    const float inv = 1.0f / __builtin_sqrtf(dsq);
+                    const float inv3 = sm[j] * f * inv * inv * inv;
+                    a1x += dx * inv3;
+                    a1y += dy * inv3;
+                }
+            }
+
+            a.ax[a.idx[k]] += a1x;
+            a.ay[a.idx[k]] += a1y;
+        }
+
+        return interactions;
+    }
+
+    static constexpr table make(isa id, const char* name) {
+        return {
+            id, name, simd::width,
+            attract_rows,
+            { { attract_tiles<false, false>, attract_tiles<false, true> },
+              { attract_tiles<true, false>, attract_tiles<true, true> } },
+            kick, drift, kick_drift,
+            bounds, encode, hilbert,
+            { potential<false>, potential<true> },
+            short_range
+        };
+    }
+}
@@ -0,0 +1,234 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <immintrin.h>
+
+/// @brief Register wrappers for the kernels, chosen by the flags of the translation unit including them. Only the
+/// per isa kernel sources include this, everything here has internal linkage so no definition compiled for one isa
+/// can be picked by the linker for another. SIMD_SCALAR forces the scalar path regardless of flags
+namespace simd {
+    static inline float frsqrt(float x) {
+        return _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+    }
+
+    /// @brief hides x from the optimizer, fast math can then not reassociate a compensated sum through it
+    static inline void fopaque(float& x) {
+        asm("" : "+x"(x));
+    }
+
+    #if defined(SIMD_SCALAR)
+        using reg = float;
+        static inline constexpr size_t width = 1;
+        static inline constexpr size_t last = 0;
+        static inline reg epsl() { return 1e-12f; }
+        static inline reg opf() { return 1.5f; }
+        static inline reg pf() { return 0.5f; }
+
+        static inline reg load(const float* p) { return *p; }
+        static inline void store(float* p, reg r) { *p = r; }
+
+        static inline reg loadu(const float* p) { return load(p); }
+        static inline void storeu(float* p, reg r) { store(p, r); }
+
+        static inline reg set1(float f) { return f; }
+        static inline reg zero() { return 0.0f; }
+
+        static inline reg rsqrt(reg d2) {
+            reg r = frsqrt(d2);
+            return r * (opf() - pf() * d2 * r * r);
+        }
+        static inline void opaque(reg& r) { fopaque(r); }
+        static inline float hsum(reg r) {
+           return r;
+        }
+
+        // integer lanes for the morton encoder, one 32 bit lane per body
+        using ireg = uint32_t;
+        static inline reg min(reg a, reg b) { return a < b ? a : b; }
+        static inline reg max(reg a, reg b) { return a > b ? a : b; }
+        static inline ireg cvtt(reg r) { return (uint32_t)(int32_t)r; }
+        static inline reg cvt(ireg r) { return (float)(int32_t)r; }
+        static inline ireg spread16(ireg v) {
+            v = (v | (v << 8)) & 0x00FF00FFu;
+            v = (v | (v << 4)) & 0x0F0F0F0Fu;
+            v = (v | (v << 2)) & 0x33333333u;
+            v = (v | (v << 1)) & 0x55555555u;
+            return v;
+        }
+        static inline ireg interleave(ireg x, ireg y) { return x | (y << 1); }
+        static inline void store_keys(uint64_t* p, ireg lo, ireg hi) { *p = ((uint64_t)hi << 32) | lo; }
+    #elif defined(__AVX512F__)
+        // gcc 12 reports the undefined pass through operand of its own avx512 intrinsics as maybe uninitialized
+        // once they are inlined, a compiler false positive
+        #pragma GCC diagnostic push
+        #pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+        using reg = __m512;
+        static inline constexpr size_t width = 16;
+        static inline constexpr size_t last = 15;
+        static inline reg epsl() { return _mm512_set1_ps(1e-12f); }
+        static inline reg opf() { return _mm512_set1_ps(1.5f); }
+        static inline reg pf() { return _mm512_set1_ps(0.5f); }
+
+        static inline reg load(const float* p) { return _mm512_load_ps(p); }
+        static inline void store(float* p, reg r) { _mm512_store_ps(p, r); }
+
+        static inline reg loadu(const float* p) { return _mm512_loadu_ps(p); }
+        static inline void storeu(float* p, reg r) { _mm512_storeu_ps(p, r); }
+
+        static inline reg set1(float f) { return _mm512_set1_ps(f); }
+        static inline reg zero() { return _mm512_setzero_ps(); }
+
+        static inline reg rsqrt(reg d2) {
+            reg r = _mm512_rsqrt14_ps(d2);
+            return r * (opf() - pf() * d2 * r * r);
+        }
+        static inline void opaque(reg& r) { asm("" : "+v"(r)); }
+        static inline float hsum(reg r) {
+            __m256 low256  = _mm512_castps512_ps256(r);
+            __m256 high256 = _mm512_extractf32x8_ps(r, 1);
+            __m256 res256  = _mm256_add_ps(low256, high256);
+
+            __m128 low128  = _mm256_castps256_ps128(res256);
+            __m128 high128 = _mm256_extractf128_ps(res256, 1);
+            __m128 res128  = _mm_add_ps(low128, high128);
+
+            __m128 shuf64  = _mm_movehdup_ps(res128);
+            __m128 res64   = _mm_add_ps(res128, shuf64);
+
+            __m128 final   = _mm_add_ss(res64, _mm_movehl_ps(res64, res64));
+
+            return _mm_cvtss_f32(final);
+        }
+
+        // integer lanes for the morton encoder, one 32 bit lane per body
+        using ireg = __m512i;
+        static inline reg min(reg a, reg b) { return _mm512_min_ps(a, b); }
+        static inline reg max(reg a, reg b) { return _mm512_max_ps(a, b); }
+        static inline ireg cvtt(reg r) { return _mm512_cvttps_epi32(r); }
+        static inline reg cvt(ireg r) { return _mm512_cvtepi32_ps(r); }
+        static inline ireg spread16(ireg v) {
+            v = _mm512_and_si512(_mm512_or_si512(v, _mm512_slli_epi32(v, 8)), _mm512_set1_epi32(0x00FF00FF));
+            v = _mm512_and_si512(_mm512_or_si512(v, _mm512_slli_epi32(v, 4)), _mm512_set1_epi32(0x0F0F0F0F));
+            v = _mm512_and_si512(_mm512_or_si512(v, _mm512_slli_epi32(v, 2)), _mm512_set1_epi32(0x33333333));
+            v = _mm512_and_si512(_mm512_or_si512(v, _mm512_slli_epi32(v, 1)), _mm512_set1_epi32(0x55555555));
+            return v;
+        }
+        static inline ireg interleave(ireg x, ireg y) { return _mm512_or_si512(x, _mm512_slli_epi32(y, 1)); }
+        static inline void store_keys(uint64_t* p, ireg lo, ireg hi) {
+            // unpacks pair lanes within each 128 bit block, the permutes put the keys back in body order
+            const __m512i a = _mm512_unpacklo_epi32(lo, hi);
+            const __m512i b = _mm512_unpackhi_epi32(lo, hi);
+            _mm512_storeu_si512(p, _mm512_permutex2var_epi64(a, _mm512_setr_epi64(0, 1, 8, 9, 2, 3, 10, 11), b));
+            _mm512_storeu_si512(p + 8, _mm512_permutex2var_epi64(a, _mm512_setr_epi64(4, 5, 12, 13, 6, 7, 14, 15), b));
+        }
+        #pragma GCC diagnostic pop
+    #elif defined(__AVX2__)
+        using reg = __m256;
+        static inline constexpr size_t width = 8;
+        static inline constexpr size_t last = 7;
+        static inline reg epsl() { return _mm256_set1_ps(1e-12f); }
+        static inline reg opf() { return _mm256_set1_ps(1.5f); }
+        static inline reg pf() { return _mm256_set1_ps(0.5f); }
+
+        static inline reg load(const float* p) { return _mm256_load_ps(p); }
+        static inline void store(float* p, reg r) { _mm256_store_ps(p, r); }
+
+        static inline reg loadu(const float* p) { return _mm256_loadu_ps(p); }
+        static inline void storeu(float* p, reg r) { _mm256_storeu_ps(p, r); }
+
+        static inline reg set1(float f) { return _mm256_set1_ps(f); }
+        static inline reg zero() { return _mm256_setzero_ps(); }
+
+        static inline reg rsqrt(reg d2) {
+            reg r = _mm256_rsqrt_ps(d2);
+            return r * (opf() - pf() * d2 * r * r);
+        }
+        static inline void opaque(reg& r) { asm("" : "+x"(r)); }
+        static inline float hsum(reg r) {
+            __m128 vlow  = _mm256_castps256_ps128(r);
+            __m128 vhigh = _mm256_extractf128_ps(r, 1);
+            __m128 v128  = _mm_add_ps(vlow, vhigh);
+
+            __m128 shuf  = _mm_movehl_ps(v128, v128);
+            __m128 v64   = _mm_add_ps(v128, shuf);
+
+            __m128 swiz  = _mm_shuffle_ps(v64, v64, _MM_SHUFFLE(1, 1, 1, 1));
+            __m128 v32   = _mm_add_ss(v64, swiz);
+
+            return _mm_cvtss_f32(v32);
+        }
+
+        // integer lanes for the morton encoder, one 32 bit lane per body
+        using ireg = __m256i;
+        static inline reg min(reg a, reg b) { return _mm256_min_ps(a, b); }
+        static inline reg max(reg a, reg b) { return _mm256_max_ps(a, b); }
+        static inline ireg cvtt(reg r) { return _mm256_cvttps_epi32(r); }
+        static inline reg cvt(ireg r) { return _mm256_cvtepi32_ps(r); }
+        static inline ireg spread16(ireg v) {
+            v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 8)), _mm256_set1_epi32(0x00FF00FF));
+            v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 4)), _mm256_set1_epi32(0x0F0F0F0F));
+            v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 2)), _mm256_set1_epi32(0x33333333));
+            v = _mm256_and_si256(_mm256_or_si256(v, _mm256_slli_epi32(v, 1)), _mm256_set1_epi32(0x55555555));
+            return v;
+        }
+        static inline ireg interleave(ireg x, ireg y) { return _mm256_or_si256(x, _mm256_slli_epi32(y, 1)); }
+        static inline void store_keys(uint64_t* p, ireg lo, ireg hi) {
+            // unpacks pair lanes within each 128 bit half, the permutes put the keys back in body order
+            const __m256i a = _mm256_unpacklo_epi32(lo, hi);
+            const __m256i b = _mm256_unpackhi_epi32(lo, hi);
+            _mm256_storeu_si256((__m256i*)p, _mm256_permute2x128_si256(a, b, 0x20));
+            _mm256_storeu_si256((__m256i*)(p + 4), _mm256_permute2x128_si256(a, b, 0x31));
+        }
+    #else
+        // sse2 is part of the x86-64 baseline, so this is the floor every build can run
+        using reg = __m128;
+        static inline constexpr size_t width = 4;
+        static inline constexpr size_t last = 3;
+        static inline reg epsl() { return _mm_set1_ps(1e-12f); }
+        static inline reg opf() { return _mm_set1_ps(1.5f); }
+        static inline reg pf() { return _mm_set1_ps(0.5f); }
+
+        static inline reg load(const float* p) { return _mm_load_ps(p); }
+        static inline void store(float* p, reg r) { _mm_store_ps(p, r); }
+
+        static inline reg loadu(const float* p) { return _mm_loadu_ps(p); }
+        static inline void storeu(float* p, reg r) { _mm_storeu_ps(p, r); }
+
+        static inline reg set1(float f) { return _mm_set1_ps(f); }
+        static inline reg zero() { return _mm_setzero_ps(); }
+
+        static inline reg rsqrt(reg d2) {
+            reg r = _mm_rsqrt_ps(d2);
+            return r * (opf() - pf() * d2 * r * r);
+        }
+        static inline void opaque(reg& r) { asm("" : "+x"(r)); }
+        static inline float hsum(reg r) {
+            __m128 shuf  = _mm_movehl_ps(r, r);
+            __m128 v64   = _mm_add_ps(r, shuf);
+
+            __m128 swiz  = _mm_shuffle_ps(v64, v64, _MM_SHUFFLE(1, 1, 1, 1));
+            __m128 v32   = _mm_add_ss(v64, swiz);
+
+            return _mm_cvtss_f32(v32);
+        }
+
+        // integer lanes for the morton encoder, one 32 bit lane per body
+        using ireg = __m128i;
+        static inline reg min(reg a, reg b) { return _mm_min_ps(a, b); }
+        static inline reg max(reg a, reg b) { return _mm_max_ps(a, b); }
+        static inline ireg cvtt(reg r) { return _mm_cvttps_epi32(r); }
+        static inline reg cvt(ireg r) { return _mm_cvtepi32_ps(r); }
+        static inline ireg spread16(ireg v) {
+            v = _mm_and_si128(_mm_or_si128(v, _mm_slli_epi32(v, 8)), _mm_set1_epi32(0x00FF00FF));
+            v = _mm_and_si128(_mm_or_si128(v, _mm_slli_epi32(v, 4)), _mm_set1_epi32(0x0F0F0F0F));
+            v = _mm_and_si128(_mm_or_si128(v, _mm_slli_epi32(v, 2)), _mm_set1_epi32(0x33333333));
+            v = _mm_and_si128(_mm_or_si128(v, _mm_slli_epi32(v, 1)), _mm_set1_epi32(0x55555555));
+            return v;
+        }
+        static inline ireg interleave(ireg x, ireg y) { return _mm_or_si128(x, _mm_slli_epi32(y, 1)); }
+        static inline void store_keys(uint64_t* p, ireg lo, ireg hi) {
+            _mm_storeu_si128((__m128i*)p, _mm_unpacklo_epi32(lo, hi));
+            _mm_storeu_si128((__m128i*)(p + 2), _mm_unpackhi_epi32(lo, hi));
+        }
+    #endif
+}
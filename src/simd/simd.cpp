@@ -0,0 +1,64 @@
+/*
+Author: Joey Soroka
+Updated: 10/17/26
+Purpose: Selects the kernel table for the running cpu
+Comments: __builtin_cpu_supports checks both the cpuid bits and that the os saves the wider registers, the avx2
+and avx512 sources also use fma so it is required alongside them
+*/
+
+#include "simd.hpp"
+#include <stdexcept>
+
+namespace {
+    const simd::table* current = nullptr;
+}
+
+simd::isa simd::detect() noexcept {
+    if (supported(AVX512)) { return AVX512; }
+    if (supported(AVX2)) { return AVX2; }
+    return SSE;
+}
+
+bool simd::supported(isa i) noexcept {
+    __builtin_cpu_init();
+
+    switch (i) {
+        case AVX512:
+            return __builtin_cpu_supports("avx512f") && __builtin_cpu_supports("avx512dq") && supported(AVX2);
+        case AVX2:
+            return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+        default:
+            // sse2 is part of the x86-64 baseline
+            return true;
+    }
+}
+
+simd::isa simd::parse(const std::string& name) {
+    if (name.empty() || name == "auto") { return detect(); }
+    if (name == "avx512") { return AVX512; }
+    if (name == "avx2") { return AVX2; }
+    if (name == "sse") { return SSE; }
+    if (name == "scalar") { return SCALAR; }
+    throw std::runtime_error("invalid isa \"" + name + "\"");
+}
+
+void simd::select(isa i) {
+    if (!supported(i)) {
+        throw std::runtime_error(std::string("isa ") + get(i).name + " is not supported by this cpu");
+    }
+    current = &get(i);
+}
+
+const simd::table& simd::active() noexcept {
+    static const table& detected = get(detect());
+    return current ? *current : detected;
+}
+
+const simd::table& simd::get(isa i) noexcept {
+    switch (i) {
+        case AVX512: return avx512_table;
+        case AVX2: return avx2_table;
+        case SSE: return sse_table;
+        default: return scalar_table;
+    }
+}
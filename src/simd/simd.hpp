@@ -0,0 +1,104 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// @brief Hot loops compiled once per instruction set and selected at startup from cpuid, so a single build runs
+/// on any x86-64 machine and still uses the widest registers the machine has. Each isa has its own translation
+/// unit built with its own flags, the rest of the program only sees the table of kernels
+namespace simd {
+    enum isa { SCALAR, SSE, AVX2, AVX512 };
+
+    /// @brief arrays a tile kernel reads and writes, the next positions and the position errors are only
+    /// touched by fused and precise kernels and may be null otherwise
+    struct tile_args {
+        size_t n;
+        const float* ma;
+        const float* px;
+        const float* py;
+        const float* pxl;
+        const float* pyl;
+        float* ax;
+        float* ay;
+        float* vx;
+        float* vy;
+        float* npx;
+        float* npy;
+        float* npxl;
+        float* npyl;
+        const uint32_t* idx;    // bodies to compute accelerations for, nullptr for every body
+        size_t count;
+        float ft;
+    };
+
+    /// @brief p3m cell list, bodies sorted by cell in row major order so start[c] to start[c+1] are the bodies
+    /// of cell c and the cells of one grid row are contiguous
+    struct cell_args {
+        const float* sx;
+        const float* sy;
+        const float* sm;
+        const uint32_t* idx;    // original index of each sorted body
+        const uint32_t* start;
+        const float* factor;    // short range factor at samples + 1 points over squared distance up to rcsq
+        size_t grid;            // cells per side
+        size_t reach;           // neighbour cells on each side within the cutoff
+        size_t samples;
+        float rcsq;
+        float* ax;
+        float* ay;
+    };
+
+    /// @brief kernels of one isa, aligned loads require every array to start on a 64 byte boundary
+    struct table {
+        isa id;
+        const char* name;
+        size_t width;
+
+        /// @brief all pairs with newtons third law, thread t accumulates into row t of ax and ay, rows are stride apart
+        void (*attract_rows)(const float* px, const float* py, const float* ma, float* ax, float* ay, size_t stride, size_t n);
+
+        /// @brief tiled all pairs, indexed [fused][precise]
+        void (*attract_tiles[2][2])(const tile_args& a);
+
+        void (*kick)(float* vx, float* vy, const float* ax, const float* ay, float dt, size_t n);
+        void (*drift)(float* px, float* py, const float* vx, const float* vy, float dt, size_t n);
+        void (*kick_drift)(float* px, float* py, float* vx, float* vy, const float* ax, const float* ay, float dt, size_t n);
+
+        /// @brief bounding box as min x, min y, max x, max y in one pass
+        void (*bounds)(const float* px, const float* py, size_t n, float* box);
+
+        /// @brief morton codes of positions normalized into the box starting at min with size r, idxs is set to identity
+        void (*encode)(const float* px, const float* py, size_t n, float minx, float miny, float rx, float ry, uint64_t* keys, uint32_t* idxs);
+
+        /// @brief hilbert keys over the same normalization as encode, idxs is set to identity
+        void (*hilbert)(const float* px, const float* py, size_t n, float minx, float miny, float rx, float ry, uint64_t* keys, uint32_t* idxs);
+
+        /// @brief sum of -m1 m2 / r over every pair, evaluated by a team of threads, indexed by [precise] as
+        /// attract_tiles, pxl and pyl are only read when precise
+        double (*potential[2])(const float* px, const float* py, const float* pxl, const float* pyl, const float* ma, size_t n, size_t threads);
+
+        /// @brief adds the short range pair force to every body of cell c, returns the pairs summed
+        size_t (*short_range)(const cell_args& a, size_t c);
+    };
+
+    // defined in the per isa sources
+    extern const table scalar_table;
+    extern const table sse_table;
+    extern const table avx2_table;
+    extern const table avx512_table;
+
+    /// @brief widest isa the cpu and os support
+    isa detect() noexcept;
+    bool supported(isa i) noexcept;
+
+    /// @brief Parses an isa name, auto resolves to detect()
+    /// @param name One of auto, avx512, avx2, sse, scalar
+    isa parse(const std::string& name);
+
+    /// @brief Makes i the isa every kernel call dispatches to, throws if the cpu does not support it
+    void select(isa i);
+
+    /// @brief selected kernels, the detected isa until select is called
+    const table& active() noexcept;
+    const table& get(isa i) noexcept;
+}
@@ -0,0 +1,11 @@
+/*
+Author: Joey Soroka
+Updated: 10/17/26
+Purpose: Builds the kernels for AVX2 with FMA
+Comments: Compile flags for this file are set in CMakeLists.txt
+*/
+
+#define SIMD_ISA avx2
+#include "kernels.hpp"
+
+const simd::table simd::avx2_table = simd::avx2::make(simd::AVX2, "avx2");
@@ -0,0 +1,11 @@
+/*
+Author: Joey Soroka
+Updated: 10/17/26
+Purpose: Builds the kernels for AVX-512F and DQ with FMA
+Comments: Compile flags for this file are set in CMakeLists.txt
+*/
+
+#define SIMD_ISA avx512
+#include "kernels.hpp"
+
+const simd::table simd::avx512_table = simd::avx512::make(simd::AVX512, "avx512");
@@ -0,0 +1,17 @@
+/*
+Author: Joey Soroka
+Updated: 10/17/26
+Purpose: Builds the kernels for the x86-64 baseline with the scalar register path
+Comments: Built with the baseline flags, only the avx sources get their own in CMakeLists.txt
+*/
+
+#define SIMD_ISA scalar
+#define SIMD_SCALAR
+#include "kernels.hpp"
+
+// wider flags here would make this table run instructions supported() never checked for
+#ifdef __AVX__
+#error "simd_scalar.cpp must be built for the x86-64 baseline"
+#endif
+
+const simd::table simd::scalar_table = simd::scalar::make(simd::SCALAR, "scalar");
@@ -0,0 +1,16 @@
+/*
+Author: Joey Soroka
+Updated: 10/17/26
+Purpose: Builds the kernels for the x86-64 baseline, SSE2
+Comments: Built with the baseline flags, only the avx sources get their own in CMakeLists.txt
+*/
+
+#define SIMD_ISA sse
+#include "kernels.hpp"
+
+// wider flags here would make this table run instructions supported() never checked for
+#ifdef __AVX__
+#error "simd_sse.cpp must be built for the x86-64 baseline"
+#endif
+
+const simd::table simd::sse_table = simd::sse::make(simd::SSE, "sse");
@@ -6,6 +6,7 @@ Comments: Currently contains the update_gpu method implementation, which doesn't
 */
 
 #include "simulation.hpp"
+#include <fstream>
 #include <random>
 
 #define TAU 6.28318530718
@@ -79,7 +80,7 @@ void simulation::init_spiral(const SpiralConfig& conf, size_t seed) noexcept {
     }
 
     // sort based on distance
-    data_.sort();
+    reorder(reorder::RADIUS).sort(data_);
 
     // scale velocites
     for (size_t i = 0; i < data_.bodies(); i++) {
@@ -123,7 +124,7 @@ void simulation::init_uniform(const UniformConfig& conf, size_t seed) noexcept {
     }
 
     // sort based on distance
-    data_.sort();
+    reorder(reorder::RADIUS).sort(data_);
 
     // scale velocites
     #pragma omp parallel for simd schedule(static)
@@ -214,7 +215,7 @@ void simulation::init_voronoi(const VoronoiConfig& conf, size_t seed) noexcept {
     }
 
     // sort based on distance
-    data_.sort();
+    reorder(reorder::RADIUS).sort(data_);
 
     // scale velocites
     for (size_t i = 0; i < data_.bodies(); i++) {
@@ -227,4 +228,23 @@ void simulation::init_voronoi(const VoronoiConfig& conf, size_t seed) noexcept {
     }
 }
 
+/// @brief Writes the current state as csv, one row per body tagged with the index it had at initialization
+/// @param path File to write to
+void simulation::dump(const std::string& path) const {
+    std::ofstream out(path);
+    if (!out) {
+        throw std::runtime_error("failed to open dump file \"" + path + "\"");
+    }
+
+    out << "id,posx,posy,velx,vely,mass\n";
+    for (size_t i = 0; i < data_.bodies(); i++) {
+        out << data_.id()[i] << ','
+            << data_.posx()[i] << ','
+            << data_.posy()[i] << ','
+            << data_.velx()[i] << ','
+            << data_.vely()[i] << ','
+            << data_.mass()[i] << '\n';
+    }
+}
+
 #undef TAU
@@ -4,49 +4,163 @@
 #include <omp.h>
 #include <chrono>
 
-#include "../quadtree/quadtree.hpp"
+#include "../radixtree/radixtree.hpp"
+#include "../reorder/reorder.hpp"
+#include "../reorder/resort.hpp"
+#include "../fmm/fmm.hpp"
+#include "../pm/pm.hpp"
+#include "../integrator/integrator.hpp"
 #include "../data/data.hpp"
+#include "../snapshot/snapshot.hpp"
 #include "../cli/cli.hpp"
+#include "../simd/simd.hpp"
+
+// gpu solver, owned by the renderer and only defined where vulkan is available
+struct Compute;
 
 struct simulation {
     public:
     enum init { CLUSTER, SPIRAL };
 
+    /// @brief time spent in each phase during the last update, integration is whatever remains of total
+    struct phases {
+        std::chrono::nanoseconds sort{0};
+        std::chrono::nanoseconds tree{0};
+        std::chrono::nanoseconds force{0};
+        std::chrono::nanoseconds total{0};
+        size_t interactions = 0;
+        size_t reorders = 0;    // tree builds that reordered the bodies, the others only refit the tree
+    };
+
+    /// @brief fmm error against the direct sum at one expansion order, relative to the magnitude of the direct acceleration
+    struct accuracy {
+        size_t order;
+        double rms;
+        double max;
+        std::chrono::nanoseconds time;
+        size_t interactions;
+    };
+
     // default constructor
     simulation() :
         data_(data()),
+        start_(0),
+        theta_(0.5f),
+        fmm_(fmm()),
+        pm_(pm()),
+        integrator_(integrator()),
+        gpu_(nullptr),
+        attract(nullptr),
         update(nullptr) {}
 
     // move constructor
     simulation(simulation&& other) noexcept : 
+        order_(std::move(other.order_)),
+        resort_(other.resort_),
         data_(std::move(other.data_)),
+        start_(other.start_),
+        theta_(other.theta_),
+        fmm_(other.fmm_),
+        pm_(other.pm_),
+        integrator_(other.integrator_),
+        gpu_(other.gpu_),
+        attract(other.attract),
         update(other.update) {}
 
     // copy constructor
     simulation(const simulation& other) noexcept :
+        order_(other.order_.type()),
+        resort_(other.resort_),
         data_(other.data_),
+        start_(other.start_),
+        theta_(other.theta_),
+        fmm_(other.fmm_),
+        pm_(other.pm_),
+        integrator_(other.integrator_),
+        gpu_(other.gpu_),
+        attract(other.attract),
         update(other.update) {}
 
     // custom constructor
     simulation(const cliargs& f) :
-        data_(f.config.Points(), f.cpu) {
-            if (f.config.Type() == "cluster") {
-                init_cluster(f.config.Cluster(), f.config.Seed());
-            } else if (f.config.Type() == "spiral") {
-                init_spiral(f.config.Spiral(), f.config.Seed());
-            } else if (f.config.Type() == "uniform") {
-                init_uniform(f.config.Uniform(), f.config.Seed());
-            } else if (f.config.Type() == "voronoi") {
-                init_voronoi(f.config.Voronoi(), f.config.Seed());
+        order_(reorder::parse(f.config.Ordering())),
+        resort_(resort::parse(f.config.Resort()), f.config.ResortEvery(), f.config.ResortThreshold()),
+        data_(data()),
+        start_(0),
+        theta_(f.config.Theta()),
+        fmm_(f.config.Order(), f.config.Theta()),
+        pm_(f.config.Grid(), f.solver == "p3m"),
+        integrator_(f.config.Integrator(), f.config.Levels(), f.config.Eta()),
+        gpu_(nullptr) {
+            if (!f.restore.empty()) {
+                // restored bodies replace the initializer entirely, including the body count
+                data_ = snapshot::restore(f.restore, acc_rows(f), start_);
+            } else {
+                data_ = data(f.config.Points(), acc_rows(f));
+
+                if (f.config.Type() == "cluster") {
+                    init_cluster(f.config.Cluster(), f.config.Seed());
+                } else if (f.config.Type() == "spiral") {
+                    init_spiral(f.config.Spiral(), f.config.Seed());
+                } else if (f.config.Type() == "uniform") {
+                    init_uniform(f.config.Uniform(), f.config.Seed());
+                } else if (f.config.Type() == "voronoi") {
+                    init_voronoi(f.config.Voronoi(), f.config.Seed());
+                } else {
+                    throw std::runtime_error("invalid initilization");
+                }
+            }
+
+            if (f.kernel == "rows") {
+                attract = &simulation::attract_points;
+            } else if (f.kernel == "tiled" || f.kernel == "fused") {
+                attract = &simulation::attract_points_tiled;
             } else {
-                throw std::runtime_error("invalid initilization");
+                throw std::runtime_error("invalid kernel");
             }
 
-            if (f.cpu) {
+            if (integrator_.type() == integrator::BLOCK) {
+                // block timesteps keep per body state by index, so bodies can never be reordered
+                if (f.solver != "direct" || !f.cpu) {
+                    throw std::runtime_error("block integrator requires the direct cpu solver");
+                }
+                update = &simulation::update_cpu_block;
+            } else if (f.solver == "bh") {
+                update = &simulation::update_cpu_bh;
+            } else if (f.solver == "fmm") {
+                update = &simulation::update_cpu_fmm;
+            } else if (f.solver == "pm" || f.solver == "p3m") {
+                update = &simulation::update_cpu_pm;
+            } else if (f.solver != "direct") {
+                throw std::runtime_error("invalid solver");
+            } else if (f.cpu && f.kernel == "fused") {
+                // the fused kernel kicks and drifts inline, which is only valid for euler
+                if (integrator_.type() != integrator::EULER) {
+                    throw std::runtime_error("fused kernel requires the euler integrator");
+                }
+                update = &simulation::update_cpu_fused;
+            } else if (f.cpu) {
                 update = &simulation::update_cpu;
             } else {
+                // the compute shader integrates inline with semi implicit euler
+                if (integrator_.type() != integrator::EULER) {
+                    throw std::runtime_error("gpu solver requires the euler integrator");
+                }
                 update = &simulation::update_gpu;
-                // TODO : Copy initial values into gpu buffers
+            }
+
+            // radial keys give annular nodes whose boxes span most of the system, so the walk degrades toward all pairs
+            if ((f.solver == "bh" || f.solver == "fmm") && order_.type() == reorder::RADIUS) {
+                throw std::runtime_error("radius ordering is not supported by the tree solvers");
+            }
+
+            // snapshots of precise runs restore precise, only tile kernels and the tree walk read the position errors
+            if (f.config.Precise()) { data_.make_precise(); }
+            if (data_.precise()) {
+                const bool tiles = f.cpu && f.solver == "direct" && (f.kernel != "rows" || integrator_.type() == integrator::BLOCK);
+                if (!tiles && f.solver != "bh") {
+                    throw std::runtime_error("precise positions require the tiled or fused kernel or the bh solver");
+                }
             }
         }
 
@@ -56,7 +170,16 @@ struct simulation {
     // move operator
     simulation& operator = (simulation&& other) noexcept {
         update = other.update;
+        order_ = std::move(other.order_);
+        resort_ = other.resort_;
         data_ = std::move(other.data_);
+        start_ = other.start_;
+        theta_ = other.theta_;
+        fmm_ = other.fmm_;
+        pm_ = other.pm_;
+        integrator_ = other.integrator_;
+        gpu_ = other.gpu_;
+        attract = other.attract;
 
         other.update = nullptr;
         return *this;
@@ -65,7 +188,16 @@ struct simulation {
     // copy operator
     simulation& operator = (const simulation& other) noexcept {
         update = other.update;
+        order_ = reorder(other.order_.type());
+        resort_ = other.resort_;
         data_ = other.data_;
+        start_ = other.start_;
+        theta_ = other.theta_;
+        fmm_ = other.fmm_;
+        pm_ = other.pm_;
+        integrator_ = other.integrator_;
+        gpu_ = other.gpu_;
+        attract = other.attract;
         return *this;
     }
     
@@ -77,16 +209,61 @@ struct simulation {
 
     size_t bodies() const noexcept { return data_.bodies(); }
 
+    /// @brief gpu solver update_gpu steps, bodies then live on the device and data keeps its initial state
+    void attach(Compute* gpu) noexcept { gpu_ = gpu; }
+    const phases& perf() const noexcept { return perf_; }
+    const resort& policy() const noexcept { return resort_; }
+
+    /// @brief step the simulation was restored at, 0 when it was initialized from the config
+    size_t start() const noexcept { return start_; }
+
+    void dump(const std::string& path) const;
+    void checkpoint(const std::string& path, size_t step) const { snapshot::write(data_, path, step); }
+    std::vector<accuracy> fmm_accuracy(size_t samples);
+
     private:
-    zcurve zcurve_;
+    reorder order_;
+    resort resort_;
+    radixtree tree_;
     data data_;
+    size_t start_;
+    float theta_;
+    fmm fmm_;
+    pm pm_;
+    integrator integrator_;
+    Compute* gpu_;
+    phases perf_;
 
+    template<typename F>
+    static std::chrono::nanoseconds timed(F&& f) {
+        auto s = std::chrono::high_resolution_clock::now();
+        f();
+        return std::chrono::high_resolution_clock::now() - s;
+    }
+
+    /// @brief all pairs kernel used by update_cpu
+    void (simulation::*attract)(const float) noexcept;
+
+    /// @brief number of acceleration rows each solver needs, the rows kernel keeps one per thread
+    static size_t acc_rows(const cliargs& f) noexcept {
+        if (f.solver != "direct") { return 1; }
+        if (!f.cpu) { return 0; }
+        return f.kernel == "rows" ? omp_get_max_threads() : 1;
+    }
 
     std::chrono::nanoseconds update_cpu_bh(const float ft) noexcept;
+    void build_tree(bool sort) noexcept;
+    template<bool precise> void attract_tree(const float ft) noexcept;
+
+    std::chrono::nanoseconds update_cpu_fmm(const float ft) noexcept;
+    std::chrono::nanoseconds update_cpu_pm(const float ft) noexcept;
 
     std::chrono::nanoseconds update_cpu(const float ft) noexcept;
+    std::chrono::nanoseconds update_cpu_fused(const float ft) noexcept;
+    std::chrono::nanoseconds update_cpu_block(const float ft) noexcept;
     void attract_points(const float ft) noexcept;
-    void move_points(const float ft) noexcept;
+    void attract_points_tiled(const float ft) noexcept;
+    void attract_tiles(const float ft, const uint32_t* idx, size_t count, bool fused) noexcept;
     void sum_acc() noexcept;
 
     std::chrono::nanoseconds update_gpu(const float ft) noexcept;
@@ -1,179 +1,108 @@
 /* 
 Author: Joey Soroka
-Updated: 2/26/26
+Updated: 10/17/26
 Purpose: Implements nbody simulation for the cpu
-Comments: Switches update_cpu implementation based on compile time definitions.
-Supports both AVX512 and AVX2 explicitly, all others will fall back on omp and
-compiler for vectorization
+Comments: The all pairs kernels are built once per isa in src/simd and dispatched
+through the table selected at startup, AVX512, AVX2 and SSE explicitly with a scalar
+fallback
 */
 
 #include "simulation.hpp"
 
 std::chrono::nanoseconds simulation::update_cpu(const float ft) noexcept {
     auto s = std::chrono::high_resolution_clock::now();
+    perf_ = {};
     
-    attract_points(ft);
-    sum_acc();
-    move_points(ft);
-
-    return std::chrono::high_resolution_clock::now() - s;
+    integrator_.step(data_, ft, [this, ft]() {
+        perf_.force += timed([&]() {
+            (this->*attract)(ft);
+            sum_acc();
+        });
+    });
+
+    perf_.interactions = integrator_.forces() * data_.bodies();
+    perf_.total = std::chrono::high_resolution_clock::now() - s;
+    return perf_.total;
 }
 
-/// @brief Generic custom simd update function
-/// @param ft Fixed time used for update
-/// @return Nanoseconds it took to run update
-void simulation::attract_points(const float ft) noexcept {
-    data_.zero_acc();
-
-    // aliasing
-    const size_t n = data_.bodies();
-    const float* __restrict ma = data_.mass();
-    float* __restrict px = data_.posx();
-    float* __restrict py = data_.posy();
-    float* __restrict vx = data_.velx();
-    float* __restrict vy = data_.vely();
-    matrix& ax = data_.accx();
-    matrix& ay = data_.accy();
-
-    // TODO : test out blocked implementation to decrease pressure on ax and ay
-
-    // gravitational constant is set to 1 for purposes of this simulation
-    #pragma omp parallel
-    {
-        int tid = omp_get_thread_num();
-        float* __restrict ax_row = ax.row(tid);
-        float* __restrict ay_row = ay.row(tid);
-
-        #pragma omp for schedule(static)
-        for (size_t i = 0; i < n; i++) {
-            const float p1x = px[i];
-            const float p1y = py[i];
-            const float p1m = ma[i];
-
-            const auto _p1x = util::set1(p1x);
-            const auto _p1y = util::set1(p1y);
-            const auto _p1m = util::set1(p1m);
-
-            auto _a1x_sum = util::zero();
-            auto _a1y_sum = util::zero();
-
-            size_t j = i+1;
-            for (; j+util::last < n; j += util::width) {
-                const auto _p2x = util::loadu(&px[j]);
-                const auto _p2y = util::loadu(&py[j]);
-                const auto _p2m = util::loadu(&ma[j]);
-
-                // compute distance squared
-                const auto _dx = _p2x - _p1x;
-                const auto _dy = _p2y - _p1y;
-                const auto _dsq = util::_epsl + (_dx*_dx) + (_dy*_dy);
-
-                // fast inv sqrt with newton step
-                const auto _inv = util::rsqrt(_dsq);
-                const auto _inv3 = _inv * _inv * _inv;
+/// @brief Single pass update, each tile of bodies is kicked and drifted as soon as its accelerations
+/// are known, new positions go into the shadow arrays as other tiles still read the current ones
+std::chrono::nanoseconds simulation::update_cpu_fused(const float ft) noexcept {
+    auto s = std::chrono::high_resolution_clock::now();
+    perf_ = {};
 
-                // compute intermediate values
-                const auto _ivx = _dx * _inv3;
-                const auto _ivy = _dy * _inv3;
+    perf_.force = timed([&]() {
+        attract_tiles(ft, nullptr, data_.bodies(), true);
+    });
+    data_.swap_pos();
 
-                // compute and store accelerations
-                util::storeu(&ax_row[j], util::loadu(&ax_row[j]) - (_ivx * _p1m));
-                util::storeu(&ay_row[j], util::loadu(&ay_row[j]) - (_ivy * _p1m));
-                _a1x_sum += _ivx * _p2m;
-                _a1y_sum += _ivy * _p2m;
-            }
+    perf_.interactions = data_.bodies() * data_.bodies();
+    perf_.total = std::chrono::high_resolution_clock::now() - s;
+    return perf_.total;
+}
 
-            float a1x_final = util::hsum(_a1x_sum);
-            float a1y_final = util::hsum(_a1y_sum);
+/// @brief Block timestep update, only bodies finishing a step on each substep have their forces computed
+std::chrono::nanoseconds simulation::update_cpu_block(const float ft) noexcept {
+    auto s = std::chrono::high_resolution_clock::now();
+    perf_ = {};
 
-            // remainder handling
-            for(; j < n; j++) {
-                const float p2x = px[j];
-                const float p2y = py[j];
-                const float p2m = ma[j];
+    integrator_.step_block(data_, ft, [this, ft](const uint32_t* idx, size_t count) {
+        perf_.force += timed([&]() {
+            attract_tiles(ft, idx, count, false);
+        });
+    });
 
-                const float dx = p2x - p1x;
-                const float dy = p2y - p1y;
-                const float dsq = 1e-12f + (dx*dx) + (dy*dy);
+    perf_.interactions = integrator_.forces() * data_.bodies();
+    perf_.total = std::chrono::high_resolution_clock::now() - s;
+    return perf_.total;
+}
 
-                // fast rsqrt with netwon step
-                float inv = util::frsqrt(dsq);
-                inv = inv * (1.5f - 0.5f * dsq * inv * inv);
+/// @brief Generic custom simd update function, uses newtons third law and accumulates into one
+/// acceleration row per thread
+/// @param ft Fixed time used for update
+void simulation::attract_points(const float ft) noexcept {
+    data_.zero_acc();
 
-                // compute intermediate values
-                float inv_dis3 = inv * inv * inv;
-                float ivx = dx * inv_dis3;
-                float ivy = dy * inv_dis3;
+    matrix& ax = data_.accx();
+    matrix& ay = data_.accy();
+    simd::active().attract_rows(data_.posx(), data_.posy(), data_.mass(), ax.row(0), ay.row(0), ax.stride(), data_.bodies());
+}
 
-                // update acceleration values
-                a1x_final += ivx * p2m;
-                a1y_final += ivy * p2m;
-                ax_row[j] -= ivx * p1m;
-                ay_row[j] -= ivy * p1m;
-            }
+void simulation::attract_points_tiled(const float ft) noexcept {
+    attract_tiles(ft, nullptr, data_.bodies(), false);
+}
 
-            ax_row[i] = a1x_final;
-            ay_row[i] = a1y_final;
-        }
-    }
+/// @brief Tiled simd update function, every body sums its full row of interactions so no per
+/// thread acceleration rows are needed, see simd::table for the kernel
+/// @param ft Fixed time used for update
+/// @param idx Bodies to compute accelerations for, nullptr for every body
+/// @param count Number of bodies in idx
+/// @param fused Also kick and drift each tile, writing positions into the shadow arrays
+void simulation::attract_tiles(const float ft, const uint32_t* idx, size_t count, bool fused) noexcept {
+    simd::tile_args a;
+    a.n = data_.bodies();
+    a.ma = data_.mass();
+    a.px = data_.posx();
+    a.py = data_.posy();
+    a.pxl = data_.posxl();
+    a.pyl = data_.posyl();
+    a.ax = data_.accx().row(0);
+    a.ay = data_.accy().row(0);
+    a.vx = data_.velx();
+    a.vy = data_.vely();
+    a.npx = data_.next_posx();
+    a.npy = data_.next_posy();
+    a.npxl = data_.next_posxl();
+    a.npyl = data_.next_posyl();
+    a.idx = idx;
+    a.count = count;
+    a.ft = ft;
+
+    simd::active().attract_tiles[fused][data_.precise()](a);
 }
 
 void simulation::sum_acc() noexcept {
-    // aliasing
-    matrix& ax = data_.accx();
-    matrix& ay = data_.accy();
-    float* __restrict ax_top = ax.row(0);
-    float* __restrict ay_top = ay.row(0);
-
     // sum acceleration into top row
-    for (size_t r = 1; r < ax.rows(); r++) {
-
-        #pragma omp parallel for simd schedule(static)
-        for (size_t c = 0; c < ax.cols(); c++) {
-            ax_top[c] += ax(r, c);
-            ay_top[c] += ay(r, c);
-        }
-    }
+    data_.accx().sum_rows();
+    data_.accy().sum_rows();
 }
-
-void simulation::move_points(const float ft) noexcept {
-    // aliasing
-    const size_t n = data_.bodies();
-    float* __restrict px = data_.posx();
-    float* __restrict py = data_.posy();
-    float* __restrict vx = data_.velx();
-    float* __restrict vy = data_.vely();
-    const float* ax = data_.accx().row(0);
-    const float* ay = data_.accy().row(0);
-
-    const auto _ft = util::set1(ft);
-
-    #pragma omp parallel for schedule(static)
-    for (size_t i = 0; i < ssize_t(n)-ssize_t(util::last); i += util::width) {
-        const auto _ax = util::load(&ax[i]);
-        const auto _ay = util::load(&ay[i]);
-        auto _vx = util::load(vx+i);
-        auto _vy = util::load(vy+i);
-        auto _px = util::load(px+i);
-        auto _py = util::load(py+i);
-
-        _vx += _ax * _ft;
-        _vy += _ay * _ft;
-        _px += _vx * _ft;
-        _py += _vy * _ft;
-        
-        util::store(vx+i, _vx);
-        util::store(vy+i, _vy);
-        util::store(px+i, _px);
-        util::store(py+i, _py);
-    }
-
-    size_t r = n - (n%util::width);
-    for (size_t i = r; i < n; i++) {
-        vx[i] += ax[i] * ft;
-        vy[i] += ay[i] * ft;
-
-        px[i] += vx[i] * ft;
-        py[i] += vy[i] * ft;
-    }
-}
\ No newline at end of file
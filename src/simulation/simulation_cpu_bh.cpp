@@ -1,52 +1,169 @@
+/*
+Author: Joey Soroka
+Updated: 10/17/26
+Purpose: Implements Barnes-Hut nbody simulation for the cpu
+Comments: Bodies are sorted along the configured ordering whenever the resort policy asks, the radix tree is
+then built over the sorted order so every node covers a contiguous range of bodies. The policy is asked once per
+step and only the first build of a step may sort, other builds refit that tree
+*/
+
 #include "simulation.hpp"
 
 std::chrono::nanoseconds simulation::update_cpu_bh(const float ft) noexcept {
-    auto start = std::chrono::high_resolution_clock::now();
-    
-    constexpr float thetasq = 0.1f;
+    auto s = std::chrono::high_resolution_clock::now();
+    perf_ = {};
 
-    // data is now sorted on a zcurve
-    zcurve_.sort(data_);
+    // integrators with several force evaluations per step build several trees, the policy counts steps
+    bool sort = resort_.next();
+    integrator_.step(data_, ft, [this, ft, &sort]() {
+        build_tree(sort);
+        sort = false;
 
-    for (size_t i = 0; i < data_.bodies(); i++) {
+        perf_.force += timed([&]() {
+            if (data_.precise()) { attract_tree<true>(ft); }
+            else { attract_tree<false>(ft); }
+        });
+    });
+    resort_.measure(perf_.interactions);
 
-        float tmass = 0.0f;
-        float tx = 0.0f;
-        float ty = 0.0f;
+    perf_.total = std::chrono::high_resolution_clock::now() - s;
+    return perf_.total;
+}
 
-        float minx, miny = std::numeric_limits<float>::max();
-        float maxx, maxy = std::numeric_limits<float>::min();
+/// @brief Sorts the bodies along the configured curve and rebuilds the tree, or refits the tree of the last sort
+/// to the current positions
+/// @param sort Whether to sort, from the resort policy for the first build of a step
+void simulation::build_tree(bool sort) noexcept {
+    if (sort) {
+        perf_.sort += timed([&]() { order_.sort(data_); });
+        perf_.tree += timed([&]() { tree_.build(data_, order_); });
+        perf_.reorders++;
+    } else {
+        perf_.tree += timed([&]() { tree_.refit(data_); });
+    }
+}
 
-        // iterate until error rate is too large
-        for (size_t j = 0; j < data_.bodies(); j++) {
-            if (i == j) continue;
+/// @brief Computes accelerations by walking the radix tree, nodes are approximated by their
+/// center of mass once size / distance falls below theta
+/// @tparam precise Add the difference of the position errors to body pairs, nodes are far enough away without them
+/// @param ft Fixed time used for update
+template<bool precise>
+void simulation::attract_tree(const float ft) noexcept {
+    // aliasing
+    const size_t n = data_.bodies();
+    const float* __restrict ma = data_.mass();
+    const float* __restrict px = data_.posx();
+    const float* __restrict py = data_.posy();
+    const float* __restrict pxl = data_.posxl();
+    const float* __restrict pyl = data_.posyl();
+    float* __restrict ax = data_.accx().row(0);
+    float* __restrict ay = data_.accy().row(0);
 
-            minx = data_.posx()[j] < minx ? data_.posx()[j] : minx;
-            maxx = data_.posx()[j] > maxx ? data_.posx()[j] : maxx;
-            miny = data_.posy()[j] < miny ? data_.posy()[j] : miny;
-            maxy = data_.posy()[j] > maxy ? data_.posy()[j] : maxy;
+    const float* __restrict tcx = tree_.cx();
+    const float* __restrict tcy = tree_.cy();
+    const float* __restrict tma = tree_.mass();
+    const float* __restrict tminx = tree_.minx();
+    const float* __restrict tminy = tree_.miny();
+    const float* __restrict tmaxx = tree_.maxx();
+    const float* __restrict tmaxy = tree_.maxy();
+    const uint32_t* __restrict tfirst = tree_.first();
+    const uint32_t* __restrict tlast = tree_.last();
+    const uint32_t* __restrict tleft = tree_.left();
+    const uint32_t* __restrict tright = tree_.right();
 
-            tx += data_.posx()[j] * data_.mass()[j];
-            ty += data_.posy()[j] * data_.mass()[j];
-            tmass += data_.mass()[j];
+    const float thetasq = theta_ * theta_;
 
-            float cx = tx / tmass;
-            float cy = ty / tmass;
+    size_t interactions = 0;
 
-            float dx = cx-data_.posx()[j];
-            float dy = cy-data_.posy()[j];
-            float dsq = dx*dx+dy*dy;
-            float s = std::max<float>(maxx-minx, maxy-miny);
-            float ssq = s*s;
+    // a single body has no tree and no forces
+    if (tree_.size() == 0) {
+        std::fill(ax, ax+n, 0.0f);
+        std::fill(ay, ay+n, 0.0f);
+        return;
+    }
 
-            if (ssq / dsq > thetasq) {
-                // need to backstep one, and treat cx, cy, and tmass as values of a single point
-            } else {
+    // gravitational constant is set to 1 for purposes of this simulation
+    #pragma omp parallel for schedule(dynamic, 256) reduction(+:interactions)
+    for (size_t i = 0; i < n; i++) {
+        const float p1x = px[i];
+        const float p1y = py[i];
+        const float p1xl = precise ? pxl[i] : 0.0f;
+        const float p1yl = precise ? pyl[i] : 0.0f;
+
+        float a1x = 0.0f;
+        float a1y = 0.0f;
+
+        // each level pushes 2 children and pops 1
+        uint32_t stack[radixtree::max_depth + 1];
+        size_t top = 0;
+        stack[top++] = 0;
+
+        while (top) {
+            const uint32_t c = stack[--top];
+
+            // single body, self interaction is zero as dx and dy are zero
+            if (c & radixtree::leaf) {
+                const uint32_t j = c & ~radixtree::leaf;
+                float dx = px[j] - p1x;
+                float dy = py[j] - p1y;
+                if constexpr (precise) {
+                    util::fopaque(dx);
+                    util::fopaque(dy);
+                    dx += pxl[j] - p1xl;
+                    dy += pyl[j] - p1yl;
+                }
+                const float dsq = 1e-12f + (dx*dx) + (dy*dy);
+
+                const float inv = 1.0f / std::sqrt(dsq);
+                const float inv3 = ma[j] * inv * inv * inv;
+                a1x += dx * inv3;
+                a1y += dy * inv3;
+                interactions++;
                 continue;
             }
+
+            const float dx = tcx[c] - p1x;
+            const float dy = tcy[c] - p1y;
+            const float dsq = 1e-12f + (dx*dx) + (dy*dy);
+            const float s = std::max(tmaxx[c] - tminx[c], tmaxy[c] - tminy[c]);
+
+            // never approximate a node containing the body itself
+            const bool inside = tfirst[c] <= i && i < tlast[c];
+
+            if (!inside && s*s < thetasq * dsq) {
+                const float inv = 1.0f / std::sqrt(dsq);
+                const float inv3 = tma[c] * inv * inv * inv;
+                a1x += dx * inv3;
+                a1y += dy * inv3;
+                interactions++;
+            } else if (tlast[c] - tfirst[c] <= radixtree::leaf_size) {
+                // small node, sum bodies directly
+                for (size_t j = tfirst[c]; j < tlast[c]; j++) {
+                    float ddx = px[j] - p1x;
+                    float ddy = py[j] - p1y;
+                    if constexpr (precise) {
+                        util::fopaque(ddx);
+                        util::fopaque(ddy);
+                        ddx += pxl[j] - p1xl;
+                        ddy += pyl[j] - p1yl;
+                    }
+                    const float ddsq = 1e-12f + (ddx*ddx) + (ddy*ddy);
+
+                    const float inv = 1.0f / std::sqrt(ddsq);
+                    const float inv3 = ma[j] * inv * inv * inv;
+                    a1x += ddx * inv3;
+                    a1y += ddy * inv3;
+                }
+                interactions += tlast[c] - tfirst[c];
+            } else {
+                stack[top++] = tright[c];
+                stack[top++] = tleft[c];
+            }
         }
 
+        ax[i] = a1x;
+        ay[i] = a1y;
     }
 
-    return std::chrono::high_resolution_clock::now() - start;
-}
\ No newline at end of file
+    perf_.interactions += interactions;
+}
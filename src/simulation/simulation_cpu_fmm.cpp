@@ -0,0 +1,96 @@
+/*
+Author: Joey Soroka
+Updated: 10/17/26
+Purpose: Implements the fast multipole nbody simulation for the cpu
+Comments: Shares the space filling curve sort and radix tree with Barnes-Hut, only the force phase differs
+*/
+
+#include "simulation.hpp"
+#include <cmath>
+
+std::chrono::nanoseconds simulation::update_cpu_fmm(const float ft) noexcept {
+    auto s = std::chrono::high_resolution_clock::now();
+    perf_ = {};
+
+    // the policy counts steps as in update_cpu_bh
+    bool sort = resort_.next();
+    integrator_.step(data_, ft, [this, &sort]() {
+        build_tree(sort);
+        sort = false;
+
+        size_t work = 0;
+        perf_.force += timed([&]() {
+            work = fmm_.evaluate(data_, tree_, data_.accx().row(0), data_.accy().row(0));
+        });
+        perf_.interactions += work;
+    });
+    resort_.measure(perf_.interactions);
+
+    perf_.total = std::chrono::high_resolution_clock::now() - s;
+    return perf_.total;
+}
+
+/// @brief Evaluates the current state at every expansion order and compares against the direct sum with the
+/// same softened kernel as attract_points, accumulated in double over an evenly spaced sample of bodies
+/// @param samples Number of bodies the direct sum is computed for
+/// @return Error and force time of every order from 1 to fmm::max_order, empty when there are no bodies
+std::vector<simulation::accuracy> simulation::fmm_accuracy(size_t samples) {
+    const size_t n = data_.bodies();
+    if (n == 0) { return {}; }
+    samples = std::clamp<size_t>(samples, 1, n);
+
+    order_.sort(data_);
+    tree_.build(data_, order_);
+
+    const float* __restrict px = data_.posx();
+    const float* __restrict py = data_.posy();
+    const float* __restrict ma = data_.mass();
+
+    std::vector<size_t> idx(samples);
+    std::vector<double> rx(samples), ry(samples);
+
+    #pragma omp parallel for schedule(static)
+    for (size_t k = 0; k < samples; k++) {
+        const size_t i = k * n / samples;
+        double ax = 0.0;
+        double ay = 0.0;
+
+        for (size_t j = 0; j < n; j++) {
+            const double dx = px[j] - px[i];
+            const double dy = py[j] - py[i];
+            const double inv = 1.0 / std::sqrt(1e-12 + dx*dx + dy*dy);
+            ax += ma[j] * dx * inv*inv*inv;
+            ay += ma[j] * dy * inv*inv*inv;
+        }
+
+        idx[k] = i;
+        rx[k] = ax;
+        ry[k] = ay;
+    }
+
+    std::vector<float> ax(n), ay(n);
+    std::vector<accuracy> report;
+    const size_t order = fmm_.order();
+
+    for (size_t p = 1; p <= fmm::max_order; p++) {
+        fmm_.set_order(p);
+
+        size_t interactions = 0;
+        auto time = timed([&]() { interactions = fmm_.evaluate(data_, tree_, ax.data(), ay.data()); });
+
+        double sum = 0.0;
+        double max = 0.0;
+        for (size_t k = 0; k < samples; k++) {
+            const double ex = ax[idx[k]] - rx[k];
+            const double ey = ay[idx[k]] - ry[k];
+            const double err = std::sqrt((ex*ex + ey*ey) / std::max(rx[k]*rx[k] + ry[k]*ry[k], 1e-30));
+            sum += err * err;
+            max = std::max(max, err);
+        }
+
+        report.push_back({ p, std::sqrt(sum / samples), max, time, interactions });
+    }
+
+    fmm_.set_order(order);
+    return report;
+}
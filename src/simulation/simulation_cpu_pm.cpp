@@ -0,0 +1,22 @@
+/*
+Author: Joey Soroka
+Updated: 10/17/26
+Purpose: Implements the particle mesh nbody simulation for the cpu
+Comments: The mesh works on bodies in any order so nothing is sorted, the p3m cell list sorts indices only
+*/
+
+#include "simulation.hpp"
+
+std::chrono::nanoseconds simulation::update_cpu_pm(const float ft) noexcept {
+    auto s = std::chrono::high_resolution_clock::now();
+    perf_ = {};
+
+    integrator_.step(data_, ft, [this]() {
+        perf_.force += timed([&]() {
+            perf_.interactions += pm_.evaluate(data_, data_.accx().row(0), data_.accy().row(0));
+        });
+    });
+
+    perf_.total = std::chrono::high_resolution_clock::now() - s;
+    return perf_.total;
+}
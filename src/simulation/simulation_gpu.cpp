@@ -1,6 +1,10 @@
 #include "simulation.hpp"
+#include "../graphics/Compute/Compute.hpp"
 
-std::chrono::nanoseconds simulation::update_gpu(const float dt) noexcept {
+/// @brief Runs a step on the attached compute solver and waits for it, so the time is the device's step time
+/// @param ft Fixed time used for update
+std::chrono::nanoseconds simulation::update_gpu(const float ft) noexcept {
     auto s = std::chrono::high_resolution_clock::now();
+    if (gpu_) { gpu_->step(ft); }
     return std::chrono::high_resolution_clock::now() - s;
 }
@@ -0,0 +1,97 @@
+/*
+Author: Joey Soroka
+Updated: 10/17/26
+Purpose: Implements writing and restoring binary snapshots
+Comments: Layout is a 64 byte header followed by posx, posy, velx, vely, mass and id, each padded
+to a multiple of 64 bytes, precise data appends the position errors. Snapshots are native endian and only meant to be restored on the same machine
+*/
+
+#include "snapshot.hpp"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+void snapshot::write(const data& d, const std::string& path, size_t step) {
+    const size_t n = d.bodies();
+    const size_t s = stride(n);
+    const uint32_t count = d.precise() ? precise_arrays : arrays;
+    const std::string tmp = path + ".tmp";
+
+    header h{};
+    memcpy(h.magic, magic, sizeof(magic));
+    h.version = version;
+    h.arrays = count;
+    h.bodies = n;
+    h.step = step;
+    h.stride = s;
+
+    FILE* file = fopen(tmp.c_str(), "wb");
+    if (!file) { throw std::runtime_error("failed to open snapshot " + tmp); }
+
+    static const char zeros[64] = {};
+    const void* src[precise_arrays] = { d.posx(), d.posy(), d.velx(), d.vely(), d.mass(), d.id(), d.posxl(), d.posyl() };
+
+    bool ok = fwrite(&h, sizeof(h), 1, file) == 1;
+    for (uint32_t k = 0; ok && k < count; k++) {
+        ok = fwrite(src[k], 4, n, file) == n && fwrite(zeros, 1, s - n*4, file) == s - n*4;
+    }
+
+    ok = fflush(file) == 0 && ok;
+    ok = fsync(fileno(file)) == 0 && ok;
+    ok = fclose(file) == 0 && ok;
+
+    if (!ok || rename(tmp.c_str(), path.c_str()) != 0) {
+        remove(tmp.c_str());
+        throw std::runtime_error("failed to write snapshot " + path);
+    }
+}
+
+data snapshot::restore(const std::string& path, size_t acc_rows, size_t& step) {
+    const int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) { throw std::runtime_error("failed to open snapshot " + path); }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(header)) {
+        close(fd);
+        throw std::runtime_error("invalid snapshot " + path);
+    }
+
+    // private writable mapping, the simulation updates the arrays in place without touching the file
+    const size_t size = st.st_size;
+    void* map = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) { throw std::runtime_error("failed to map snapshot " + path); }
+
+    const header* h = (const header*)map;
+    const char* msg = nullptr;
+    if (memcmp(h->magic, magic, sizeof(magic)) != 0) {
+        msg = "not a snapshot ";
+    } else if (h->version != version) {
+        msg = "unsupported snapshot version ";
+    } else if ((h->arrays != arrays && h->arrays != precise_arrays) || h->stride != stride(h->bodies) ||
+        size < sizeof(header) + h->arrays * h->stride) {
+        msg = "corrupt snapshot ";
+    }
+
+    if (msg) {
+        munmap(map, size);
+        throw std::runtime_error(msg + path);
+    }
+
+    madvise(map, size, MADV_WILLNEED);
+    step = h->step;
+
+    char* base = (char*)map + sizeof(header);
+    const size_t s = h->stride;
+    const bool precise = h->arrays == precise_arrays;
+    return data(
+        h->bodies, acc_rows, map, size,
+        (float*)(base), (float*)(base + s), (float*)(base + 2*s),
+        (float*)(base + 3*s), (float*)(base + 4*s), (uint32_t*)(base + 5*s),
+        precise ? (float*)(base + 6*s) : nullptr, precise ? (float*)(base + 7*s) : nullptr
+    );
+}
@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "../data/data.hpp"
+
+/// @brief Versioned binary snapshots of the body arrays, every array starts on a 64 byte boundary
+/// so a snapshot can be mapped and used in place on restart
+namespace snapshot {
+    inline constexpr char magic[8] = {'N', 'B', 'O', 'D', 'Y', 'S', 'N', 'P'};
+    inline constexpr uint32_t version = 1;
+
+    // posx, posy, velx, vely, mass, id, then posxl and posyl for precise data
+    inline constexpr uint32_t arrays = 6;
+    inline constexpr uint32_t precise_arrays = 8;
+
+    struct header {
+        char magic[8];
+        uint32_t version;
+        uint32_t arrays;
+        uint64_t bodies;
+        uint64_t step;
+        uint64_t stride;
+        uint8_t reserved[24];
+    };
+    static_assert(sizeof(header) == 64, "snapshot header must stay 64 bytes");
+
+    /// @brief bytes between the start of consecutive arrays
+    inline constexpr size_t stride(size_t bodies) noexcept { return (bodies * 4 + 63) & ~(size_t)63; }
+
+    /// @brief Writes a snapshot next to path then renames it over path, a crash never leaves a partial file
+    /// @param d Body data to write
+    /// @param path Destination file
+    /// @param step Step the snapshot was taken at
+    void write(const data& d, const std::string& path, size_t step);
+
+    /// @brief Maps a snapshot privately, arrays are used in place and pages are only copied once written
+    /// @param path Snapshot file
+    /// @param acc_rows Acceleration rows to allocate, see data
+    /// @param step Set to the step the snapshot was taken at
+    /// @return Body data backed by the mapping
+    data restore(const std::string& path, size_t acc_rows, size_t& step);
+}
@@ -0,0 +1,85 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <omp.h>
+#include <vector>
+
+/// @brief Parallel LSD radix sort of 64 bit keys carrying a 32 bit index, passes over digits that
+/// are equal for every key are skipped and scratch buffers are kept between calls
+struct radix {
+    private:
+    static constexpr size_t bits = 11;
+    static constexpr size_t buckets = 1 << bits;
+    static constexpr uint64_t mask = buckets - 1;
+
+    std::vector<uint64_t> tkeys;
+    std::vector<uint32_t> tvals;
+    std::vector<size_t> hist;
+
+    public:
+    /// @brief Stable sort of keys in ascending order, vals are permuted alongside their keys
+    inline void sort(std::vector<uint64_t>& keys, std::vector<uint32_t>& vals) noexcept {
+        const size_t n = keys.size();
+        if (n < 2) { return; }
+
+        tkeys.resize(n);
+        tvals.resize(n);
+        hist.resize(omp_get_max_threads() * buckets);
+
+        // bits that differ between any two keys, digits without any can be skipped
+        uint64_t kor = 0;
+        uint64_t kand = ~0ULL;
+
+        #pragma omp parallel for simd schedule(static) reduction(|:kor) reduction(&:kand)
+        for (size_t i = 0; i < n; i++) {
+            kor |= keys[i];
+            kand &= keys[i];
+        }
+        const uint64_t diff = kor ^ kand;
+
+        for (size_t shift = 0; shift < 64; shift += bits) {
+            if (((diff >> shift) & mask) == 0) { continue; }
+
+            const uint64_t* __restrict sk = keys.data();
+            const uint32_t* __restrict sv = vals.data();
+            uint64_t* __restrict dk = tkeys.data();
+            uint32_t* __restrict dv = tvals.data();
+
+            #pragma omp parallel
+            {
+                // every thread owns a contiguous chunk to keep the scatter stable
+                const size_t tid = omp_get_thread_num();
+                const size_t nt = omp_get_num_threads();
+                const size_t begin = n * tid / nt;
+                const size_t end = n * (tid+1) / nt;
+                size_t* __restrict h = &hist[tid * buckets];
+
+                for (size_t d = 0; d < buckets; d++) { h[d] = 0; }
+                for (size_t i = begin; i < end; i++) { h[(sk[i] >> shift) & mask]++; }
+
+                #pragma omp barrier
+                #pragma omp single
+                {
+                    // exclusive prefix sum, digit major then thread
+                    size_t sum = 0;
+                    for (size_t d = 0; d < buckets; d++) {
+                        for (size_t t = 0; t < nt; t++) {
+                            const size_t c = hist[t * buckets + d];
+                            hist[t * buckets + d] = sum;
+                            sum += c;
+                        }
+                    }
+                }
+
+                for (size_t i = begin; i < end; i++) {
+                    const size_t pos = h[(sk[i] >> shift) & mask]++;
+                    dk[pos] = sk[i];
+                    dv[pos] = sv[i];
+                }
+            }
+
+            keys.swap(tkeys);
+            vals.swap(tvals);
+        }
+    }
+};
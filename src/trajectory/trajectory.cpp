@@ -0,0 +1,145 @@
+/*
+Author: Joey Soroka
+Updated: 10/17/26
+Purpose: Implements the asynchronous trajectory writer
+Comments: The simulation thread only ever copies into a free slot, the writer thread owns the file
+and any compression. When every slot is full the simulation waits, which is reported as backpressure.
+After a failed write the writer keeps releasing slots without writing so the simulation never blocks on it
+*/
+
+#include "trajectory.hpp"
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <zlib.h>
+
+trajectory::trajectory(const std::string& path, size_t bodies, size_t every, bool compress, size_t slots) :
+    file_(fopen(path.c_str(), "wb")),
+    path_(path),
+    bodies_(bodies),
+    every_(every),
+    compress_(compress),
+    done_(false),
+    failed_(false),
+    slots_(std::max<size_t>(slots, 1)),
+    queued_(0),
+    written_(0) {
+        if (!file_) { throw std::runtime_error("failed to open trajectory " + path); }
+
+        header h{};
+        memcpy(h.magic, magic, sizeof(magic));
+        h.version = version;
+        h.flags = compress_ ? (uint32_t)COMPRESSED : 0u;
+        h.bodies = bodies_;
+        h.every = every_;
+        if (fwrite(&h, sizeof(h), 1, file_) != 1) {
+            fclose(file_);
+            throw std::runtime_error("failed to write trajectory " + path);
+        }
+
+        // every allocation happens here, slots are reused in ring order so recording a frame never allocates
+        for (size_t i = 0; i < slots_.size(); i++) {
+            slots_[i].frame.resize(bodies_ * (2*sizeof(float) + sizeof(uint32_t)));
+        }
+
+        writer_ = std::thread(&trajectory::write_loop, this);
+    }
+
+trajectory::~trajectory() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        done_ = true;
+    }
+    cv_.notify_all();
+    writer_.join();
+    fclose(file_);
+}
+
+void trajectory::record(const data& d, size_t step) {
+    {
+        std::unique_lock<std::mutex> lock(mutex_);
+        if (queued_ - written_ == slots_.size()) {
+            auto s = std::chrono::high_resolution_clock::now();
+            cv_.wait(lock, [this]() { return queued_ - written_ < slots_.size(); });
+            stats_.stalls++;
+            stats_.waited += std::chrono::high_resolution_clock::now() - s;
+        }
+    }
+
+    // copied outside the lock, the writer never touches a slot that is not queued
+    slot& s = slots_[queued_ % slots_.size()];
+    const size_t fbytes = bodies_*sizeof(float);
+    s.step = step;
+    memcpy(s.frame.data(), d.posx(), fbytes);
+    memcpy(s.frame.data() + fbytes, d.posy(), fbytes);
+    memcpy(s.frame.data() + 2*fbytes, d.id(), bodies_*sizeof(uint32_t));
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        queued_++;
+    }
+    cv_.notify_all();
+}
+
+void trajectory::flush() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    cv_.wait(lock, [this]() { return written_ == queued_; });
+    if (fflush(file_) != 0) { failed_ = true; }
+    if (failed_) { throw std::runtime_error("failed to write trajectory " + path_); }
+}
+
+trajectory::stats trajectory::perf() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stats_;
+}
+
+void trajectory::write_loop() {
+    std::vector<uint8_t> packed(compress_ ? compressBound(slots_[0].frame.size()) : 0);
+
+    while (true) {
+        size_t i;
+        bool failed;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            cv_.wait(lock, [this]() { return done_ || written_ < queued_; });
+            if (written_ == queued_) { break; }
+            i = written_ % slots_.size();
+            failed = failed_;
+        }
+
+        size_t bytes = 0;
+        const bool ok = !failed && write_frame(slots_[i], packed, bytes);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            written_++;
+            if (ok) {
+                stats_.frames++;
+                stats_.bytes += bytes;
+            } else {
+                failed_ = true;
+            }
+        }
+        cv_.notify_all();
+    }
+
+    fflush(file_);
+}
+
+bool trajectory::write_frame(const slot& s, std::vector<uint8_t>& packed, size_t& bytes) {
+    chunk c{ s.step, s.frame.size(), s.frame.size() };
+    const uint8_t* payload = s.frame.data();
+
+    // frames that fail to compress or do not shrink are stored raw
+    if (compress_) {
+        uLongf len = packed.size();
+        if (compress2(packed.data(), &len, s.frame.data(), s.frame.size(), Z_BEST_SPEED) == Z_OK && len < c.raw) {
+            c.stored = len;
+            payload = packed.data();
+        }
+    }
+
+    if (fwrite(&c, sizeof(c), 1, file_) != 1 || fwrite(payload, 1, c.stored, file_) != c.stored) { return false; }
+    bytes = sizeof(c) + c.stored;
+    return true;
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "../data/data.hpp"
+
+/// @brief Streams positions to a chunked file from a background thread, frames are copied into a
+/// ring of preallocated slots so the copy is the only cost on the simulation thread. ids are stored
+/// with every frame as solvers may reorder bodies between frames. A failed write is sticky, later
+/// frames are dropped and flush reports it
+struct trajectory {
+    public:
+    static constexpr char magic[8] = {'N', 'B', 'O', 'D', 'Y', 'T', 'R', 'J'};
+    static constexpr uint32_t version = 1;
+
+    /// @brief file header, followed by one chunk per frame
+    struct header {
+        char magic[8];
+        uint32_t version;
+        uint32_t flags;
+        uint64_t bodies;
+        uint64_t every;
+    };
+
+    /// @brief chunk header, the payload is posx, posy then id, zlib compressed when the file is flagged
+    /// compressed and stored is smaller than raw
+    struct chunk {
+        uint64_t step;
+        uint64_t raw;
+        uint64_t stored;
+    };
+
+    enum flag : uint32_t { COMPRESSED = 1 };
+
+    /// @brief writer backpressure, stalls counts frames that had to wait for a free slot
+    struct stats {
+        size_t frames = 0;
+        size_t stalls = 0;
+        size_t bytes = 0;
+        std::chrono::nanoseconds waited{0};
+    };
+
+    // custom constructor, slots is the number of frames that can be in flight at once
+    trajectory(const std::string& path, size_t bodies, size_t every, bool compress, size_t slots = 2);
+
+    trajectory(const trajectory&) = delete;
+    trajectory& operator = (const trajectory&) = delete;
+
+    // deconstructor, writes every queued frame before returning
+    ~trajectory();
+
+    inline bool due(size_t step) const noexcept { return every_ && step % every_ == 0; }
+
+    /// @brief Copies the current positions into the next slot of the ring and queues it for writing,
+    /// only one thread may record
+    /// @param d Simulation data
+    /// @param step Step the frame belongs to
+    void record(const data& d, size_t step);
+
+    /// @brief Blocks until every queued frame has been written, throws if any write failed
+    void flush();
+
+    /// @brief snapshot of the writer statistics, safe to call while the writer runs
+    stats perf();
+
+    private:
+    // frames are laid out exactly as the uncompressed payload
+    struct slot {
+        size_t step;
+        std::vector<uint8_t> frame;
+    };
+
+    FILE* file_;
+    std::string path_;
+    size_t bodies_;
+    size_t every_;
+    bool compress_;
+    bool done_;
+    bool failed_;           // a write failed, sticky until the writer is destroyed
+    std::vector<slot> slots_;
+    size_t queued_;         // frames recorded, the next one goes in slot queued_ % slots
+    size_t written_;        // frames written or dropped, always at most queued_
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    stats stats_;
+    std::thread writer_;
+
+    void write_loop();
+    bool write_frame(const slot& s, std::vector<uint8_t>& packed, size_t& bytes);
+};
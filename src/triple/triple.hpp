@@ -0,0 +1,52 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <utility>
+
+/// @brief Lock free single producer single consumer triple buffer, the producer always has a buffer
+/// to write into and the consumer always reads the latest published one, neither ever waits
+template<typename T>
+struct triple {
+    public:
+    // custom constructor, every buffer starts as a copy of init
+    explicit triple(const T& init) : triple(init, init, init) {}
+
+    // custom constructor, for buffers that refer to distinct storage
+    triple(const T& a, const T& b, const T& c) : buffers_{a, b, c}, middle_(1), back_(0), front_(2) {}
+
+    triple(const triple&) = delete;
+    triple& operator = (const triple&) = delete;
+
+    /// @brief buffer owned by the producer, only valid until the next publish
+    inline T& back() noexcept { return buffers_[back_]; }
+
+    /// @brief buffer owned by the consumer, only valid until the next acquire
+    inline const T& front() const noexcept { return buffers_[front_]; }
+
+    /// @brief Producer side, swaps the written back buffer with the middle one and marks it fresh
+    inline void publish() noexcept {
+        back_ = middle_.exchange(back_ | fresh, std::memory_order_acq_rel) & index;
+    }
+
+    /// @brief Consumer side, true if something was published since the last acquire
+    inline bool pending() const noexcept { return middle_.load(std::memory_order_relaxed) & fresh; }
+
+    /// @brief Consumer side, takes the middle buffer if something was published since the last call
+    /// @return true if front changed
+    inline bool acquire() noexcept {
+        if (!pending()) { return false; }
+        front_ = middle_.exchange(front_, std::memory_order_acq_rel) & index;
+        return true;
+    }
+
+    private:
+    static constexpr uint8_t index = 0x3;
+    static constexpr uint8_t fresh = 0x4;
+
+    T buffers_[3];
+
+    // index of the middle buffer, with the fresh bit set while it holds an unread frame
+    std::atomic<uint8_t> middle_;
+    uint8_t back_;
+    uint8_t front_;
+};
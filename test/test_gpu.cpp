@@ -0,0 +1,106 @@
+/*
+Purpose: Checks the compute shader solver against the cpu direct solver, both stepping the same bodies with euler
+Comments: Runs on any vulkan device without a window, point VK_DRIVER_FILES at the lavapipe icd to run it on the
+cpu. Exits with 77, which ctest reports as skipped, when no device can be created. Both solvers sum every pair in
+float with their own rsqrt and order, so positions are compared relative to the size of the system
+*/
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <exception>
+#include <string>
+#include <vector>
+
+#include "../src/simulation/simulation.hpp"
+#include "../src/graphics/Compute/Compute.hpp"
+
+static constexpr int skipped = 77;
+static constexpr size_t bodies = 1024;
+static constexpr size_t steps = 10;
+static constexpr double tolerance = 1e-3;
+
+int main(int argc, char** argv) {
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s CONFIG\n", argv[0]);
+        return 1;
+    }
+
+    cliargs f;
+    f.path = argv[1];
+    f.config.Load(f.path);
+    f.config.Set("points", bodies);
+    f.config.Set("integrator", std::string("euler"));
+    f.solver = "direct";
+    f.kernel = "tiled";
+    f.headless = true;
+
+    // device first, a host without one skips before any simulation is built
+    vk::raii::Context context;
+    vk::raii::Instance instance = nullptr;
+    PhysicalDevice pd;
+    LogicalDevice ld;
+    try {
+        constexpr vk::ApplicationInfo appInfo {
+            .pApplicationName = "nbody_test_gpu",
+            .applicationVersion = VK_MAKE_VERSION( 1, 0, 0 ),
+            .pEngineName        = "No Engine",
+            .engineVersion      = VK_MAKE_VERSION( 1, 0, 0 ),
+            .apiVersion         = vk::ApiVersion13
+        };
+
+        instance = vk::raii::Instance(context, vk::InstanceCreateInfo { .pApplicationInfo = &appInfo });
+        pd.init(instance);
+        ld.init_compute(pd);
+    } catch (const std::exception& e) {
+        fprintf(stderr, "skipped, no vulkan device: %s\n", e.what());
+        return skipped;
+    }
+
+    try {
+        f.cpu = true;
+        simulation cpu(f);
+
+        f.cpu = false;
+        simulation gpu(f);
+
+        MassBuffer masses;
+        Compute compute;
+        masses.init(gpu.bodies(), ld, pd);
+        compute.init(gpu.get_data(), ld, pd, masses);
+        gpu.attach(&compute);
+
+        const float ft = f.config.Fixedtime();
+        for (size_t i = 0; i < steps; i++) {
+            (cpu.*cpu.update)(ft);
+            (gpu.*gpu.update)(ft);
+        }
+
+        const size_t n = cpu.bodies();
+        std::vector<float> px(n), py(n);
+        compute.download(pd, px.data(), py.data());
+
+        double radius = 0.0;
+        double error = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            const double x = cpu.posx()[i];
+            const double y = cpu.posy()[i];
+            radius = std::max(radius, std::sqrt(x*x + y*y));
+            error = std::max(error, std::hypot(px[i] - x, py[i] - y));
+        }
+
+        const double relative = error / std::max(radius, 1e-30);
+        printf("%zu bodies, %zu steps on %s, largest position difference %.3e of the system radius\n",
+            n, steps, pd.Device().getProperties().deviceName.data(), relative);
+
+        if (!(relative <= tolerance)) {
+            fprintf(stderr, "gpu positions differ from the cpu by more than %.0e\n", tolerance);
+            return 1;
+        }
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    return 0;
+}